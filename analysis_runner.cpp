@@ -1,24 +1,50 @@
 
+#include "include/o3Affinity.h"
+#include "include/o3Cancel.h"
+#include "include/o3Events.h"
+#include "include/o3Grid.h"
+#include "include/o3Priority.h"
+#include "include/o3Shard.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <condition_variable>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 // Mutex for logging
 std::mutex io_mutex;
 
-// Thread pool implementation
+// JSON-lines events (--events-fd=N) and the run's progress
+O3EventSink events;
+std::chrono::steady_clock::time_point runStart;
+size_t runTotal = 0;
+std::atomic<size_t> runDone{0}, runFailed{0};
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+// Thread pool implementation; with a placement, worker i runs on NUMA node
+// i % nodes (and so do the fits it starts)
 class ThreadPool {
 public:
-  ThreadPool(size_t numThreads) {
+  ThreadPool(size_t numThreads, O3Placement *placement = nullptr) {
     for (size_t i = 0; i < numThreads; ++i) {
-      workers.emplace_back([this] {
+      workers.emplace_back([this, i, placement] {
+        if (placement)
+          placement->pinToNode(static_cast<int>(i % placement->nodes()));
         while (true) {
           std::function<void()> task;
           {
@@ -66,37 +92,130 @@ private:
 };
 
 // Function to run one analysis
-void run_analysis(int nEveOffSet, int lat, int lon, int alpha) {
-  std::ostringstream name;
-  name << "LAT" << lat << "LON" << lon;
+void run_analysis(int nEveOffSet, const std::string &name, int alpha) {
+  // After SIGINT/SIGTERM the queued fits are dropped; running ones finish
+  if (o3Cancelled())
+    return;
 
   std::ostringstream cmd;
-  cmd << "./chi2LRSO3vsSnRunApp -E" << nEveOffSet << " -N" << name.str()
+  cmd << "./chi2LRSO3vsSnRunApp -E" << nEveOffSet << " -N" << name
       << " -I" << alpha;
 
   {
     std::lock_guard<std::mutex> lock(io_mutex);
     std::cout << "== START " << cmd.str() << " ==" << std::endl;
   }
+  events.emit(O3Event("task_start").str("location", name));
 
-  int ret = system(cmd.str().c_str());
+  // A fit killed by Ctrl-C cancels the run and counts as cancelled
+  auto t0 = std::chrono::steady_clock::now();
+  int ret = o3RunCommand(cmd.str());
+  const bool cancelled = ret != 0 && o3Cancelled();
+  const size_t done = cancelled ? runDone.load() : ++runDone;
+  const size_t failed =
+      ret == 0 || cancelled ? runFailed.load() : ++runFailed;
+
+  if (events.enabled()) {
+    const double seconds = secondsSince(t0);
+    events.emit(O3Event("task_end")
+                    .str("location", name)
+                    .flag("ok", ret == 0)
+                    .flag("cancelled", cancelled)
+                    .num("seconds", seconds));
+    if (ret != 0 && !cancelled) {
+      events.emit(O3Event("error")
+                      .str("location", name)
+                      .str("message", "chi2LRSO3vsSnRunApp failed"));
+    }
+    const double elapsed = secondsSince(runStart);
+    const double rate = elapsed > 0 ? done / elapsed : 0;
+    events.emit(O3Event("progress")
+                    .count("done", done)
+                    .count("failed", failed)
+                    .count("total", runTotal)
+                    .num("elapsed", elapsed)
+                    .num("rate", rate)
+                    .num("eta", rate > 0 && done < runTotal
+                                    ? (runTotal - done) / rate
+                                    : 0));
+  }
 
   {
     std::lock_guard<std::mutex> lock(io_mutex);
-    std::cout << "============================================== END "
-              << name.str() << " == (ret=" << ret << ")" << std::endl;
-    for (int k = 0; k < 20; ++k) {
-      std::cout << "============================================== END "
-                << name.str() << " ==" << std::endl;
-    }
-    std::cout << std::endl;
+    std::cout << "== END " << name << " (ret=" << ret << ") ==" << std::endl;
   }
 }
 
 int main(int argc, char *argv[]) {
+  // "--shard i/N" runs the locations of the shard.plan that
+  // optimized_ozone_processor wrote with the same option; "--events-fd=N" writes JSON-lines
+  // progress events to descriptor N; "--focus=..." and "--priority-file=F"
+  // order the fits as the processor orders the locations; "--pin=cores|nodes"
+  // pins the workers and their fits to cores or NUMA nodes
+  O3Shard shard;
+  bool sharded = false;
+  std::unique_ptr<O3Focus> focus;
+  std::unique_ptr<std::unordered_map<std::string, size_t>> ranks;
+  std::unique_ptr<O3Placement> placement;
+  int nArgs = 0;
+  for (int i = 0; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--events-fd=", 0) == 0) {
+      char *end;
+      const long fd = std::strtol(arg.c_str() + 12, &end, 10);
+      if (*end != '\0' || end == arg.c_str() + 12 || fd < 0 || fd > INT_MAX) {
+        std::cerr << "Invalid events descriptor: " << arg << std::endl;
+        return 1;
+      }
+      if (!events.open(static_cast<int>(fd))) {
+        std::cerr << "Events descriptor is not open: " << arg << std::endl;
+        return 1;
+      }
+    } else if (arg.rfind("--focus=", 0) == 0) {
+      focus.reset(new O3Focus);
+      if (!o3ParseFocus(arg.substr(8), *focus)) {
+        std::cerr << "Invalid focus: " << arg << std::endl;
+        return 1;
+      }
+    } else if (arg.rfind("--priority-file=", 0) == 0) {
+      std::string error;
+      ranks.reset(new std::unordered_map<std::string, size_t>);
+      if (!o3ReadPriorityFile(arg.substr(16), *ranks, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+    } else if (arg.rfind("--pin=", 0) == 0) {
+      O3PinMode mode;
+      if (!o3ParsePinMode(arg.substr(6), mode)) {
+        std::cerr << "Invalid pinning: " << arg << std::endl;
+        return 1;
+      }
+      placement.reset(mode == O3PinMode::None ? nullptr
+                                              : new O3Placement(mode));
+    } else if (arg == "--shard" || arg.rfind("--shard=", 0) == 0) {
+      // "--shard i/N" or "--shard=i/N"
+      std::string value = arg.size() > 7 ? arg.substr(8) : "";
+      if (arg.size() == 7 && i + 1 < argc) {
+        value = argv[++i];
+      }
+      if (!o3ParseShard(value, shard)) {
+        std::cerr << "Invalid shard (expected i/N, 1 <= i <= N): " << value
+                  << std::endl;
+        return 1;
+      }
+      sharded = true;
+    } else {
+      argv[nArgs++] = argv[i];
+    }
+  }
+  argc = nArgs;
+
   if (argc != 4) {
     std::cerr << "Usage: " << argv[0]
               << " <nEveOffSet> <grid precision i.e 10|5|2> <alpha>"
+                 " [--shard i/N] [--events-fd=N] [--focus=<lat>,<lon>|"
+                 "<latMin>,<latMax>,<lonMin>,<lonMax>] [--priority-file=F]"
+                 " [--pin=cores|nodes]"
               << std::endl;
     return 1;
   }
@@ -109,14 +228,61 @@ int main(int argc, char *argv[]) {
   int lonMin = -180, lonMax = 180;
 
   const size_t NUM_THREADS = std::thread::hardware_concurrency(); // auto detect
-  ThreadPool pool(NUM_THREADS > 0 ? NUM_THREADS : 8);
 
-  for (int lon = lonMin; lon <= lonMax; lon += gridPrecision) {
-    for (int lat = latMin; lat <= latMax; lat += gridPrecision) {
-      pool.enqueue([=] { run_analysis(nEveOffSet, lat, lon, alpha); });
+  // A shard fits the locations the processor's shard wrote to shard.plan
+  // here, whatever their grid, ranges or points file
+  std::vector<O3Location> locations;
+  if (sharded) {
+    O3Shard planned;
+    if (!o3ReadShardPlan(O3_SHARD_PLAN_NAME, planned, locations)) {
+      std::cerr << "Cannot read " << O3_SHARD_PLAN_NAME
+                << "; run optimized_ozone_processor with --shard "
+                << shard.index << "/" << shard.count << " here first"
+                << std::endl;
+      return 1;
     }
+    if (planned.index != shard.index || planned.count != shard.count) {
+      std::cerr << O3_SHARD_PLAN_NAME << " is shard " << planned.index << "/"
+                << planned.count << ", not " << shard.index << "/"
+                << shard.count << std::endl;
+      return 1;
+    }
+  } else {
+    locations = o3GridLocations(
+        O3Grid(latMin, latMax, lonMin, lonMax, gridPrecision));
+  }
+  if (focus || ranks) {
+    o3PrioritizeLocations(locations, focus.get(), ranks.get());
   }
 
-  // ThreadPool destructor waits for all tasks
+  o3InstallCancelHandlers();
+  runStart = std::chrono::steady_clock::now();
+  runTotal = locations.size();
+  events.emit(O3Event("run_start")
+                  .str("mode", "analysis")
+                  .count("locations", locations.size())
+                  .count("pending", locations.size())
+                  .count("workers", NUM_THREADS > 0 ? NUM_THREADS : 8));
+  {
+    if (placement)
+      std::cout << "Placement: " << placement->describe() << std::endl;
+    ThreadPool pool(NUM_THREADS > 0 ? NUM_THREADS : 8, placement.get());
+    for (const O3Location &loc : locations) {
+      const std::string name = loc.name;
+      pool.enqueue([=] { run_analysis(nEveOffSet, name, alpha); });
+    }
+    // ThreadPool destructor waits for all tasks
+  }
+  events.emit(O3Event("run_end")
+                  .flag("ok", runFailed == 0 && !o3Cancelled())
+                  .flag("cancelled", o3Cancelled())
+                  .count("done", runDone)
+                  .count("failed", runFailed)
+                  .num("seconds", secondsSince(runStart)));
+  if (o3Cancelled()) {
+    std::cerr << "Cancelled: " << runDone << " of " << locations.size()
+              << " analyses run" << std::endl;
+    return 130;
+  }
   return 0;
 }
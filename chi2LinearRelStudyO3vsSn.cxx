@@ -20,7 +20,13 @@
 #include <TH1.h>
 #include <TMath.h>
 #include <TStyle.h>
+#include <TSystem.h>
 #include <iomanip>
+#include <sstream>
+
+#include "include/npyWriter.h"
+#include "include/o3Archive.h"
+#include "include/o3TextIO.h"
 
 using namespace std;
 //===================================================
@@ -143,6 +149,9 @@ int main(int argc, char *argv[]) {
   strcat(outFileErrName, preLoc);
   strcat(outFileErrName, "_snavuderr.dat");
 
+  // Outputs go to skim_preloc/ even when its inputs come from a packed run
+  gSystem->mkdir(dirName, kTRUE);
+
   // --- Create ROOT file in skim_preloc folder ---
   std::string rootFileName = std::string(dirName) + "asvssn.root";
   TFile *file = new TFile(rootFileName.c_str(), "RECREATE");
@@ -166,8 +175,12 @@ int main(int argc, char *argv[]) {
   c2->cd(2)->cd(1)->Divide(1, 2);
 
   // --- File streams ---
-  ifstream inSnFile, inSnFileSkim, inFile, inSortFile, inSortLines;
-  ofstream outFile, outFileErr, outFileErrSkim, outFitLinear;
+  // Data files are read and written whole through o3TextIO; only the two
+  // line sort log and the fit table use streams
+  O3TextReader inSnFile, inSnFileSkim, inSortFile;
+  ifstream inSortLines;
+  O3TextWriter outFile, outFileErr, outFileErrSkim;
+  ofstream outFitLinear;
 
   char outFileErrSkimName[500];
   strcpy(outFileErrSkimName, dirName);
@@ -202,18 +215,10 @@ int main(int argc, char *argv[]) {
 
   inSnFile.open(pathSnFileName);
   cout << "inSnFile: " << pathSnFileName << endl;
-  while (!inSnFile.eof()) {
+  while (inSnFile.row(snYY, snMM, snDD, dat, sn[nSn + 1], snSD[nSn + 1], dat,
+                      dat)) {
     nSn++;
 
-    inSnFile >> snYY;
-    inSnFile >> snMM;
-    inSnFile >> snDD;
-    inSnFile >> dat;
-    inSnFile >> sn[nSn];
-    inSnFile >> snSD[nSn];
-    inSnFile >> dat;
-    inSnFile >> dat;
-
     if (nSn == 73779)
       cout << nSn << " " << sn[nSn] << endl;
 
@@ -241,18 +246,10 @@ int main(int argc, char *argv[]) {
   inSnFileSkim.open(pathSnFileNameSkim);
   cout << "inSnFileSkim: " << pathSnFileNameSkim << endl;
 
-  while (!inSnFileSkim.eof()) {
+  while (inSnFileSkim.row(snYY, snMM, snDD, dat, snSkim[nSnSkim + 1],
+                          snSkimSD[nSnSkim + 1], dat, dat)) {
     nSnSkim++;
 
-    inSnFileSkim >> snYY;
-    inSnFileSkim >> snMM;
-    inSnFileSkim >> snDD;
-    inSnFileSkim >> dat;
-    inSnFileSkim >> snSkim[nSnSkim];
-    inSnFileSkim >> snSkimSD[nSnSkim];
-    inSnFileSkim >> dat;
-    inSnFileSkim >> dat;
-
     if (snSkim[nSnSkim] == 270) {
       // cout << snYY << snMM << snDD << " ------------>SD 270: " <<
       // snSkimSD[nSnSkim] << endl;
@@ -280,14 +277,17 @@ int main(int argc, char *argv[]) {
   // cout <<  nSnSkim << " " << snSkim[nSnSkim] << endl;
   // cout << "arrMax: " << arrMax << " " << "size sn: " << binSnMax << endl;
 
-  inFile.open(pathFileName);
+  // skim series from disk, or from the run archive (run.o3a) once packed
+  string skimData;
+  if (!o3ReadArtifact(pathFileName, skimData)) {
+    cerr << "Cannot read skim data: " << pathFileName << endl;
+    return 1;
+  }
+  O3TextReader inFile;
+  inFile.assign(std::move(skimData));
   cout << "inFile: " << pathFileName << endl;
-  while (!inFile.eof()) {
+  while (inFile.row(udDD, udMM, udYY, ud[nUd + 1])) {
     nUd++;
-    inFile >> udDD;
-    inFile >> udMM;
-    inFile >> udYY;
-    inFile >> ud[nUd];
 
     if (ud[nUd] > 200)
       udSkim[nUd] = ud[nUd];
@@ -301,9 +301,11 @@ int main(int argc, char *argv[]) {
     }
     ud_vs_dd->SetBinContent(nUd, ud[nUd]);
   }
-  inFile.close();
 
   outFile.open(outFileName);
+  // Same rows as binary .npy for the Python analyses (np.load, mmap_mode='r')
+  NpyWriter<Double_t> npySnavud(
+      (string(dirName) + preLoc + "_snavud.npy"), {3});
 
   cout << "outFileName: " << outFileName << endl;
   cout << "nUd: " << nUd << endl;
@@ -313,11 +315,14 @@ int main(int argc, char *argv[]) {
     if (snSkim[id] > 0.0) {
       if (ud[id] > 0.0) {
         // outFile << snSkim[id] << "\t" << ud[id] << endl;
-        outFile << snSkim[id] << "\t" << ud[id] << "\t" << snSkimSD[id] << endl;
+        outFile << snSkim[id] << "\t" << ud[id] << "\t" << snSkimSD[id] << '\n';
+        const Double_t row[3] = {snSkim[id], ud[id], snSkimSD[id]};
+        npySnavud.writeRow(row);
       }
     }
   }
   outFile.close();
+  npySnavud.close();
 
   // --- Build sort and log paths inside dirName ---
   char sortFile[500];
@@ -413,10 +418,19 @@ int main(int argc, char *argv[]) {
 
   outFileErr.open(outFileErrName);
   outFileErrSkim.open(outFileErrSkimName);
-  while (!inSortFile.eof()) {
-    inSortFile >> sortSn;
-    inSortFile >> sortUd;
-    inSortFile >> sortSnSD; // from sn Standar Deviation (SD) in sortfile.dat
+  // Columns: sn, <ud>, erX, erY, udMax, udMin, events, mean abs deviation
+  NpyWriter<Double_t> npyErr((string(dirName) + preLoc + "_snavuderr.npy"),
+                             {8});
+  NpyWriter<Double_t> npyErrSkim(
+      (string(dirName) + preLoc + "_snavuderrskim.npy"), {8});
+  bool sortRow = true;
+  while (sortRow) {
+    // sortSn, sortUd, sortSnSD (SD from sn Standar Deviation) in
+    // sortfile.dat; one pass past the last row with sortSn = 0 closes the
+    // last sn bin
+    sortRow = inSortFile.row(sortSn, sortUd, sortSnSD);
+    if (!sortRow)
+      sortSn = 0;
 
     // cout << sortSn << " " << sortUd << " " << sortSnSD << endl;
 
@@ -504,7 +518,11 @@ int main(int argc, char *argv[]) {
       outFileErr << erSn[contEr] << "\t" << erUd[contEr] << "\t" << erX[contEr]
                  << "\t" << erY[contEr] << "\t\t" << udMax[contEr] << "\t"
                  << udMin[contEr] << "\t" << ev[contEr] << "\t" << absDS[contEr]
-                 << endl;
+                 << '\n';
+      const Double_t errRow[8] = {erSn[contEr],  erUd[contEr],  erX[contEr],
+                                  erY[contEr],   udMax[contEr], udMin[contEr],
+                                  ev[contEr],    absDS[contEr]};
+      npyErr.writeRow(errRow);
 
       if (nEv > nEvOffSet) {
         if (erY[contEr] > 0) {
@@ -524,7 +542,8 @@ int main(int argc, char *argv[]) {
                          << erYSkim[contErSkim] << "\t" << udMaxSkim[contErSkim]
                          << "\t" << udMinSkim[contErSkim] << "\t"
                          << evSkim[contErSkim] << "\t" << absDSSkim[contErSkim]
-                         << endl;
+                         << '\n';
+          npyErrSkim.writeRow(errRow);
         }
       }
 
@@ -539,6 +558,8 @@ int main(int argc, char *argv[]) {
   inSortFile.close();
   outFileErr.close();
   outFileErrSkim.close();
+  npyErr.close();
+  npyErrSkim.close();
 
   cout << "contEr: " << contEr << endl;
   cout << "contErSkim: " << contErSkim << endl;
@@ -674,6 +695,20 @@ int main(int argc, char *argv[]) {
   outFitLinear.open(outFitLinearName);
   cout << "name: -->" << outFitLinearName << endl;
 
+  // Rows: all events, events > nEvOffSet. Columns: a0, a1, chi2/ndf, chi2,
+  // ndf, err a0, err a1, prob
+  NpyWriter<Double_t> npyFit((string(dirName) + preLoc + "_fitlinear.npy"),
+                             {8});
+  auto writeFitRow = [&]() {
+    const Double_t fitRow[8] = {
+        fitFcn->GetParameter(0), fitFcn->GetParameter(1),
+        (fitFcn->GetChisquare()) / (fitFcn->GetNDF()),
+        fitFcn->GetChisquare(), (Double_t)fitFcn->GetNDF(),
+        fitFcn->GetParError(0), fitFcn->GetParError(1), fitFcn->GetProb()};
+    npyFit.writeRow(fitRow);
+  };
+  writeFitRow();
+
   outFitLinear << fixed << showpoint << setprecision(4)
                << fitFcn->GetParameter(0) << "\t" << fitFcn->GetParameter(1)
                << "\t" << (fitFcn->GetChisquare()) / (fitFcn->GetNDF()) << "\t"
@@ -716,6 +751,8 @@ int main(int argc, char *argv[]) {
                << fitFcn->GetParError(0) << "\t" << fitFcn->GetParError(1)
                << "\t" << fitFcn->GetProb() << "\t" << endl;
   outFitLinear.close();
+  writeFitRow();
+  npyFit.close();
 
   cout << "Events cut off  " << nEvOffSet
        << " chi2/ndf: " << fitFcn->GetChisquare() / fitFcn->GetNDF() << endl;
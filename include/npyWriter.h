@@ -0,0 +1,139 @@
+// npyWriter.h
+// Streaming writer for NumPy .npy files (format version 1.0), so results can
+// be loaded from Python with np.load(path, mmap_mode='r') and no parsing.
+//
+// Rows are appended straight from the caller's buffers; the leading
+// dimension is patched into the header when the writer is closed:
+//   NpyWriter<double> npy("LAT0LON0_snavuderr.npy", {8});
+//   npy.writeRow(row);      // row holds 8 doubles
+//   npy.close();            // shape becomes (nRows, 8)
+//
+// Header only and ROOT-free so it can be used from the compiled tools and
+// from ROOT macros.
+
+#ifndef NPYWRITER_H
+#define NPYWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <typename T> constexpr const char *npyDescr() {
+  static_assert(std::is_same<T, float>::value ||
+                    std::is_same<T, double>::value ||
+                    std::is_same<T, int32_t>::value ||
+                    std::is_same<T, int64_t>::value ||
+                    std::is_same<T, uint8_t>::value,
+                "npy element type must be float, double, int32_t, int64_t "
+                "or uint8_t");
+  if (std::is_same<T, float>::value)
+    return "<f4";
+  if (std::is_same<T, double>::value)
+    return "<f8";
+  if (std::is_same<T, int32_t>::value)
+    return "<i4";
+  if (std::is_same<T, int64_t>::value)
+    return "<i8";
+  return "|u1";
+}
+
+template <typename T> class NpyWriter {
+private:
+  FILE *fp = nullptr;
+  std::vector<size_t> rowShape; // trailing dimensions
+  size_t rowElems = 1;
+  size_t nRows = 0;
+  size_t headerSize = 0;
+
+  std::string headerDict(size_t rows) const {
+    std::string shape = "(" + std::to_string(rows) + ",";
+    for (size_t d : rowShape)
+      shape += " " + std::to_string(d) + ",";
+    shape += ")";
+    return std::string("{'descr': '") + npyDescr<T>() +
+           "', 'fortran_order': False, 'shape': " + shape + ", }";
+  }
+
+  // Magic, version, header length and dict padded with spaces to a
+  // multiple of 64 bytes, terminated by '\n'
+  bool writeHeader(size_t rows) {
+    std::string dict = headerDict(rows);
+    size_t total = headerSize ? headerSize : 0;
+    if (!total) {
+      // Reserve room for the largest possible row count
+      size_t longest = 10 + headerDict(SIZE_MAX).size() + 1;
+      total = (longest + 63) / 64 * 64;
+    }
+    dict.append(total - 10 - dict.size() - 1, ' ');
+    dict += '\n';
+
+    const uint16_t len = static_cast<uint16_t>(dict.size());
+    const unsigned char preamble[10] = {
+        0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+        static_cast<unsigned char>(len & 0xff),
+        static_cast<unsigned char>(len >> 8)};
+    if (std::fseek(fp, 0, SEEK_SET) != 0 ||
+        std::fwrite(preamble, 1, 10, fp) != 10 ||
+        std::fwrite(dict.data(), 1, dict.size(), fp) != dict.size())
+      return false;
+    headerSize = total;
+    return true;
+  }
+
+public:
+  NpyWriter(const std::string &path, std::vector<size_t> trailing = {})
+      : rowShape(std::move(trailing)) {
+    for (size_t d : rowShape)
+      rowElems *= d;
+    fp = std::fopen(path.c_str(), "wb");
+    if (fp && !writeHeader(0)) {
+      std::fclose(fp);
+      fp = nullptr;
+    }
+  }
+
+  ~NpyWriter() { close(); }
+
+  NpyWriter(const NpyWriter &) = delete;
+  NpyWriter &operator=(const NpyWriter &) = delete;
+
+  bool isOpen() const { return fp != nullptr; }
+  size_t rows() const { return nRows; }
+
+  // Appends one row of rowElems values
+  bool writeRow(const T *row) { return write(row, 1); }
+
+  // Appends n rows stored contiguously
+  bool write(const T *data, size_t n) {
+    if (!fp)
+      return false;
+    if (std::fwrite(data, sizeof(T), n * rowElems, fp) != n * rowElems)
+      return false;
+    nRows += n;
+    return true;
+  }
+
+  // Patches the row count into the header and closes the file
+  bool close() {
+    if (!fp)
+      return false;
+    bool ok = writeHeader(nRows);
+    ok = (std::fclose(fp) == 0) && ok;
+    fp = nullptr;
+    return ok;
+  }
+};
+
+// Writes a whole array in one call; shape[0] is the number of rows
+template <typename T>
+bool npySave(const std::string &path, const T *data,
+             const std::vector<size_t> &shape) {
+  if (shape.empty())
+    return false;
+  NpyWriter<T> npy(path, std::vector<size_t>(shape.begin() + 1, shape.end()));
+  return npy.write(data, shape[0]) && npy.close();
+}
+
+#endif
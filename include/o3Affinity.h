@@ -0,0 +1,164 @@
+// o3Affinity.h
+// CPU pinning and NUMA placement of worker threads (--pin=cores|nodes).
+//
+// The topology is read from /sys/devices/system/node/node*/cpulist and
+// limited to the CPUs this process may run on; without NUMA information
+// all CPUs form one node. Workers are spread round-robin over the nodes:
+//
+//   nodes   a worker may run on any CPU of its node
+//   cores   each worker gets its own CPU of its node (wrapping around
+//           when there are more workers than CPUs)
+//
+// Memory follows the thread that first touches it (Linux default policy),
+// so series a pinned worker allocates stay on its node. Child processes
+// started by a pinned worker (stage executables, fits) inherit its CPUs.
+//
+// Header only, no ROOT dependencies (Linux).
+
+#ifndef O3AFFINITY_H
+#define O3AFFINITY_H
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum class O3PinMode { None, Cores, Nodes };
+
+inline bool o3ParsePinMode(const std::string &text, O3PinMode &mode) {
+  if (text == "none")
+    mode = O3PinMode::None;
+  else if (text == "cores")
+    mode = O3PinMode::Cores;
+  else if (text == "nodes")
+    mode = O3PinMode::Nodes;
+  else
+    return false;
+  return true;
+}
+
+// "0-3,8-11" as a CPU list
+inline std::vector<int> o3ParseCpuList(const std::string &text) {
+  std::vector<int> cpus;
+  std::stringstream in(text);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    int lo, hi;
+    const int n = std::sscanf(range.c_str(), "%d-%d", &lo, &hi);
+    if (n == 1)
+      hi = lo;
+    else if (n != 2)
+      continue;
+    for (int c = lo; c <= hi; ++c)
+      cpus.push_back(c);
+  }
+  return cpus;
+}
+
+struct O3NumaNode {
+  int id;
+  std::vector<int> cpus;
+};
+
+// NUMA nodes with at least one CPU this process may use, by node id
+inline std::vector<O3NumaNode> o3NumaNodes() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  auto usable = [&](const std::vector<int> &cpus) {
+    std::vector<int> out;
+    for (int c : cpus) {
+      if (c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &allowed))
+        out.push_back(c);
+    }
+    return out;
+  };
+
+  std::vector<O3NumaNode> nodes;
+  const char *root = "/sys/devices/system/node";
+  if (DIR *dir = opendir(root)) {
+    while (dirent *entry = readdir(dir)) {
+      int id;
+      char tail;
+      if (std::sscanf(entry->d_name, "node%d%c", &id, &tail) != 1)
+        continue;
+      std::ifstream list(std::string(root) + "/" + entry->d_name +
+                         "/cpulist");
+      std::string text;
+      std::getline(list, text);
+      O3NumaNode node{id, usable(o3ParseCpuList(text))};
+      if (!node.cpus.empty())
+        nodes.push_back(node);
+    }
+    closedir(dir);
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const O3NumaNode &a, const O3NumaNode &b) { return a.id < b.id; });
+
+  if (nodes.empty()) {
+    O3NumaNode all{0, {}};
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+      if (CPU_ISSET(c, &allowed))
+        all.cpus.push_back(c);
+    }
+    nodes.push_back(all);
+  }
+  return nodes;
+}
+
+class O3Placement {
+private:
+  O3PinMode mode;
+  std::vector<O3NumaNode> topology;
+  std::vector<size_t> nextCore; // per node, for cores mode
+  std::mutex mutex;
+
+public:
+  explicit O3Placement(O3PinMode pinMode)
+      : mode(pinMode), topology(o3NumaNodes()),
+        nextCore(topology.size(), 0) {}
+
+  int nodes() const { return static_cast<int>(topology.size()); }
+
+  // Pins the calling thread to node (any of its CPUs), or to the node's
+  // next free core in cores mode; false if the kernel refused
+  bool pinToNode(int node) {
+    if (mode == O3PinMode::None)
+      return true;
+    const O3NumaNode &n = topology[node % topology.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (mode == O3PinMode::Cores) {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t &next = nextCore[node % topology.size()];
+      CPU_SET(n.cpus[next++ % n.cpus.size()], &set);
+    } else {
+      for (int c : n.cpus)
+        CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  }
+
+  // e.g. "2 NUMA nodes (node 0: 16 CPUs, node 1: 16 CPUs), workers pinned
+  // to cores"
+  std::string describe() const {
+    std::ostringstream out;
+    out << topology.size() << " NUMA node" << (topology.size() > 1 ? "s" : "")
+        << " (";
+    for (size_t i = 0; i < topology.size(); ++i) {
+      out << (i ? ", " : "") << "node " << topology[i].id << ": "
+          << topology[i].cpus.size() << " CPUs";
+    }
+    out << "), workers pinned to "
+        << (mode == O3PinMode::Cores ? "cores" : "nodes");
+    return out.str();
+  }
+};
+
+#endif
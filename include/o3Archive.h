@@ -0,0 +1,335 @@
+// o3Archive.h
+// Single-file archive of a run's per-location artifacts (yearly .dat files,
+// skim series, chi2 side files, ROOT files), replacing one directory and
+// dozens of small files per location.
+//
+// Layout (little endian):
+//   "O3ARCH01"                          8 byte magic
+//   artifact blobs                      concatenated, 8 byte aligned
+//   keys                                "<location>\n<artifact>" strings
+//   index                               open addressing hash table of
+//                                       O3ArchiveEntry, nSlots = 2^k
+//   O3ArchiveTrailer                    last 48 bytes of the file
+//
+// Artifacts are named relative to their location:
+//   LAT0LON0/LAT0LON0_1979.dat            -> (LAT0LON0, LAT0LON0_1979.dat)
+//   skim_LAT0LON0/LAT0LON0_snavud.dat     -> (LAT0LON0, skim/LAT0LON0_snavud.dat)
+// o3ArchiveKey() maps an on-disk path to that pair and o3ReadArtifact()
+// reads a path from disk or, when it is not there, from the run archive,
+// so readers work the same on packed and unpacked runs.
+
+#ifndef O3ARCHIVE_H
+#define O3ARCHIVE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Default archive name inside a run directory (override with O3_ARCHIVE)
+constexpr const char *O3_ARCHIVE_NAME = "run.o3a";
+
+struct O3ArchiveEntry {
+  uint64_t hash;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t keyOffset;
+  uint32_t keyLen; // 0 marks an empty slot
+};
+
+struct O3ArchiveTrailer {
+  uint64_t keysOffset;
+  uint64_t keysSize;
+  uint64_t indexOffset;
+  uint64_t nSlots;
+  uint64_t nEntries;
+  char magic[8]; // "O3AIDX01"
+};
+
+// FNV-1a, 64 bit
+inline uint64_t o3Hash64(std::string_view s) {
+  uint64_t h = 1469598103934665603ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+inline std::string o3ArchiveJoin(std::string_view location,
+                                 std::string_view artifact) {
+  std::string key(location);
+  key += '\n';
+  key += artifact;
+  return key;
+}
+
+// Maps "<dir>/<file>" of a run to (location, artifact); false if the path
+// does not belong to a location directory
+inline bool o3ArchiveKey(const std::string &path, std::string &location,
+                         std::string &artifact) {
+  std::string p = path;
+  while (p.rfind("./", 0) == 0)
+    p = p.substr(2);
+  const size_t slash = p.rfind('/');
+  if (slash == std::string::npos || slash == 0)
+    return false;
+  std::string dir = p.substr(0, slash);
+  const size_t parent = dir.rfind('/');
+  if (parent != std::string::npos)
+    dir = dir.substr(parent + 1);
+  const std::string file = p.substr(slash + 1);
+
+  if (dir.rfind("skim_", 0) == 0) {
+    location = dir.substr(5);
+    artifact = "skim/" + file;
+  } else {
+    location = dir;
+    artifact = file;
+  }
+  return !location.empty() && !file.empty();
+}
+
+class O3ArchiveWriter {
+private:
+  std::ofstream out;
+  uint64_t pos = 0;
+  struct Pending {
+    std::string key;
+    uint64_t offset, size;
+  };
+  std::vector<Pending> entries;
+  bool finished = false;
+
+  void pad() {
+    static const char zeros[8] = {};
+    const uint64_t rem = pos % 8;
+    if (rem) {
+      out.write(zeros, 8 - rem);
+      pos += 8 - rem;
+    }
+  }
+
+public:
+  explicit O3ArchiveWriter(const std::string &path)
+      : out(path, std::ios::binary | std::ios::trunc) {
+    if (!out.is_open())
+      throw std::runtime_error("Cannot create archive: " + path);
+    out.write("O3ARCH01", 8);
+    pos = 8;
+  }
+
+  ~O3ArchiveWriter() {
+    if (!finished)
+      finish();
+  }
+
+  O3ArchiveWriter(const O3ArchiveWriter &) = delete;
+  O3ArchiveWriter &operator=(const O3ArchiveWriter &) = delete;
+
+  size_t size() const { return entries.size(); }
+
+  void add(const std::string &location, const std::string &artifact,
+           const char *data, uint64_t size) {
+    entries.push_back({o3ArchiveJoin(location, artifact), pos, size});
+    out.write(data, static_cast<std::streamsize>(size));
+    pos += size;
+    pad();
+  }
+
+  bool addFile(const std::string &location, const std::string &artifact,
+               const std::string &filePath) {
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open())
+      return false;
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    add(location, artifact, contents.data(), contents.size());
+    return true;
+  }
+
+  // Writes keys, hash index and trailer. Called by the destructor if needed.
+  bool finish() {
+    if (finished)
+      return out.good();
+    finished = true;
+
+    O3ArchiveTrailer tr{};
+    tr.keysOffset = pos;
+    std::vector<O3ArchiveEntry> slots;
+    uint64_t nSlots = 1;
+    while (nSlots < 2 * entries.size())
+      nSlots <<= 1;
+    slots.assign(nSlots, O3ArchiveEntry{});
+
+    uint64_t keyPos = 0;
+    for (const auto &e : entries) {
+      O3ArchiveEntry ent{o3Hash64(e.key), e.offset, e.size,
+                         static_cast<uint32_t>(keyPos),
+                         static_cast<uint32_t>(e.key.size())};
+      uint64_t s = ent.hash & (nSlots - 1);
+      while (slots[s].keyLen != 0)
+        s = (s + 1) & (nSlots - 1);
+      slots[s] = ent;
+      out.write(e.key.data(), e.key.size());
+      keyPos += e.key.size();
+    }
+    pos += keyPos;
+    tr.keysSize = keyPos;
+    pad();
+
+    tr.indexOffset = pos;
+    tr.nSlots = nSlots;
+    tr.nEntries = entries.size();
+    std::memcpy(tr.magic, "O3AIDX01", 8);
+    out.write(reinterpret_cast<const char *>(slots.data()),
+              slots.size() * sizeof(O3ArchiveEntry));
+    out.write(reinterpret_cast<const char *>(&tr), sizeof(tr));
+    out.close();
+    return !out.fail();
+  }
+};
+
+// Memory-mapped reader; find() is a single hash probe sequence.
+class O3Archive {
+private:
+  int fd = -1;
+  size_t mapSize = 0;
+  const char *base = nullptr;
+  const O3ArchiveTrailer *tr = nullptr;
+  const O3ArchiveEntry *slots = nullptr;
+  const char *keys = nullptr;
+
+public:
+  explicit O3Archive(const std::string &path) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open archive: " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 ||
+        st.st_size < (off_t)(8 + sizeof(O3ArchiveTrailer))) {
+      ::close(fd);
+      throw std::runtime_error("Not an archive: " + path);
+    }
+    mapSize = static_cast<size_t>(st.st_size);
+    void *p = ::mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Cannot map archive: " + path);
+    }
+    base = static_cast<const char *>(p);
+    tr = reinterpret_cast<const O3ArchiveTrailer *>(
+        base + mapSize - sizeof(O3ArchiveTrailer));
+    if (std::memcmp(base, "O3ARCH01", 8) != 0 ||
+        std::memcmp(tr->magic, "O3AIDX01", 8) != 0 ||
+        tr->indexOffset + tr->nSlots * sizeof(O3ArchiveEntry) >
+            mapSize - sizeof(O3ArchiveTrailer)) {
+      ::munmap(p, mapSize);
+      ::close(fd);
+      throw std::runtime_error("Corrupt archive: " + path);
+    }
+    slots = reinterpret_cast<const O3ArchiveEntry *>(base + tr->indexOffset);
+    keys = base + tr->keysOffset;
+  }
+
+  ~O3Archive() {
+    if (base)
+      ::munmap(const_cast<char *>(base), mapSize);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  O3Archive(const O3Archive &) = delete;
+  O3Archive &operator=(const O3Archive &) = delete;
+
+  size_t size() const { return tr->nEntries; }
+
+  // Contents of an artifact; data() is nullptr if it is not archived
+  std::string_view find(std::string_view location,
+                        std::string_view artifact) const {
+    const std::string key = o3ArchiveJoin(location, artifact);
+    const uint64_t h = o3Hash64(key);
+    const uint64_t mask = tr->nSlots - 1;
+    for (uint64_t s = h & mask;; s = (s + 1) & mask) {
+      const O3ArchiveEntry &e = slots[s];
+      if (e.keyLen == 0)
+        return std::string_view();
+      if (e.hash == h && key == std::string_view(keys + e.keyOffset, e.keyLen))
+        return std::string_view(base + e.offset, e.size);
+    }
+  }
+
+  // All (location, artifact) pairs, optionally for one location
+  std::vector<std::pair<std::string, std::string>>
+  list(const std::string &location = "") const {
+    std::vector<std::pair<std::string, std::string>> out;
+    for (uint64_t s = 0; s < tr->nSlots; ++s) {
+      const O3ArchiveEntry &e = slots[s];
+      if (e.keyLen == 0)
+        continue;
+      std::string key(keys + e.keyOffset, e.keyLen);
+      const size_t nl = key.find('\n');
+      std::string loc = key.substr(0, nl);
+      if (location.empty() || loc == location)
+        out.emplace_back(loc, key.substr(nl + 1));
+    }
+    return out;
+  }
+};
+
+// Archive of the run in runDir (O3_ARCHIVE overrides), opened once per
+// process; nullptr if there is none
+inline const O3Archive *o3RunArchive(const std::string &runDir = ".") {
+  static std::unique_ptr<O3Archive> archive;
+  static std::string openedFor;
+  static bool tried = false;
+  if (tried && openedFor == runDir)
+    return archive.get();
+  tried = true;
+  openedFor = runDir;
+  archive.reset();
+
+  const char *env = std::getenv("O3_ARCHIVE");
+  const std::string path = env ? env : runDir + "/" + O3_ARCHIVE_NAME;
+  if (::access(path.c_str(), R_OK) == 0) {
+    try {
+      archive.reset(new O3Archive(path));
+    } catch (const std::exception &) {
+    }
+  }
+  return archive.get();
+}
+
+// Reads a run file from disk, falling back to the run archive
+inline bool o3ReadArtifact(const std::string &path, std::string &contents,
+                           const std::string &runDir = ".") {
+  std::ifstream in(path, std::ios::binary);
+  if (in.is_open()) {
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+    return true;
+  }
+
+  std::string location, artifact;
+  const O3Archive *archive = o3RunArchive(runDir);
+  if (!archive || !o3ArchiveKey(path, location, artifact))
+    return false;
+  std::string_view blob = archive->find(location, artifact);
+  if (!blob.data())
+    return false;
+  contents.assign(blob.data(), blob.size());
+  return true;
+}
+
+#endif
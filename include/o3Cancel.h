@@ -0,0 +1,88 @@
+// o3Cancel.h
+// Process-wide cancellation token, set by SIGINT or SIGTERM.
+//
+// The first signal only raises the token: schedulers stop handing out
+// locations, extractors stop between data files and roll their location
+// back, and work that already finished is committed and recorded. A second
+// signal terminates the process at once (default action).
+//
+// Stage executables and fits run through o3RunCommand rather than
+// std::system: glibc's system() ignores SIGINT in the whole process while a
+// child runs, which with several workers starting children back to back
+// hides Ctrl-C from the handler almost always.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3CANCEL_H
+#define O3CANCEL_H
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <signal.h>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+
+extern char **environ;
+
+inline std::atomic<bool> &o3CancelFlag() {
+  static std::atomic<bool> flag{false};
+  return flag;
+}
+
+inline bool o3Cancelled() {
+  return o3CancelFlag().load(std::memory_order_relaxed);
+}
+
+inline void o3RequestCancel() { o3CancelFlag().store(true); }
+
+inline void o3OnCancelSignal(int sig) {
+  if (o3CancelFlag().exchange(true)) {
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+  }
+}
+
+// Routes SIGINT and SIGTERM to the token
+inline void o3InstallCancelHandlers() {
+  static_assert(std::atomic<bool>::is_always_lock_free,
+                "the cancel flag is set from a signal handler");
+  o3CancelFlag();
+  struct sigaction sa = {};
+  sa.sa_handler = o3OnCancelSignal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+}
+
+// True if the wait status is a child killed by SIGINT or SIGQUIT, or a
+// shell that exited with 128 + one of them because its child was
+inline bool o3InterruptedStatus(int status) {
+  if (WIFSIGNALED(status))
+    return WTERMSIG(status) == SIGINT || WTERMSIG(status) == SIGQUIT;
+  return WIFEXITED(status) && (WEXITSTATUS(status) == 128 + SIGINT ||
+                               WEXITSTATUS(status) == 128 + SIGQUIT);
+}
+
+// Runs command with /bin/sh -c like std::system and returns the same wait
+// status (-1 if the shell could not be started). The cancel handlers stay
+// installed meanwhile; a Ctrl-C that killed the child cancels the run.
+inline int o3RunCommand(const std::string &command) {
+  const char *argv[] = {"sh", "-c", command.c_str(), nullptr};
+  pid_t pid;
+  if (posix_spawn(&pid, "/bin/sh", nullptr, nullptr,
+                  const_cast<char *const *>(argv), environ) != 0)
+    return -1;
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      return -1;
+  }
+  if (o3InterruptedStatus(status))
+    o3RequestCancel();
+  return status;
+}
+
+#endif
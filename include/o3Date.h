@@ -0,0 +1,131 @@
+// o3Date.h
+// Calendar arithmetic on days since 1970-01-01 (int32), the one date
+// representation of the pipeline, the store and the macros. Everything
+// but o3ParseCivil is constexpr:
+//
+//   static_assert(o3DaysFromCivil(2005, 1, 1) == 12784);
+//   const O3Civil c = o3Civil(day); // c.year, c.month, c.day
+//
+// The civil conversions are the days_from_civil / civil_from_days
+// algorithms of H. Hinnant: integer arithmetic only, no loops or branches
+// on the date.
+//
+// Header only, no dependencies (also usable from ROOT macros).
+
+#ifndef O3DATE_H
+#define O3DATE_H
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+
+struct O3Civil {
+  int year, month, day;
+};
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+constexpr int32_t o3DaysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+// Inverse of o3DaysFromCivil
+constexpr O3Civil o3Civil(int32_t z) {
+  z += 719468;
+  const int era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  const int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  return {static_cast<int>(yoe) + era * 400 + (m <= 2), m, d};
+}
+
+constexpr void o3CivilFromDays(int32_t z, int &y, int &m, int &d) {
+  const O3Civil c = o3Civil(z);
+  y = c.year;
+  m = c.month;
+  d = c.day;
+}
+
+constexpr bool o3IsLeap(int y) {
+  return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+constexpr int o3DaysInYear(int y) { return o3IsLeap(y) ? 366 : 365; }
+
+// Days before each month in common [0] and leap [1] years; [12] is the
+// length of the year
+constexpr int16_t O3_MONTH_START[2][13] = {
+    {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365},
+    {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366}};
+
+constexpr int o3DaysInMonth(int y, int m) {
+  return O3_MONTH_START[o3IsLeap(y)][m] - O3_MONTH_START[o3IsLeap(y)][m - 1];
+}
+
+// 1 for Jan 1
+constexpr int o3DayOfYear(int32_t day) {
+  const O3Civil c = o3Civil(day);
+  return O3_MONTH_START[o3IsLeap(c.year)][c.month - 1] + c.day;
+}
+
+// Month (1-12) of a day of year (1-366)
+constexpr int o3MonthOfDayOfYear(int doy, bool leap) {
+  int m = 1;
+  while (m < 12 && doy > O3_MONTH_START[leap][m])
+    ++m;
+  return m;
+}
+
+// Calendar day in a leap year (0-365): Feb 29 is 59, and Mar 1 is 60 in
+// every year, so the same date of different years shares its slot
+constexpr int o3LeapSlot(int32_t day) {
+  const O3Civil c = o3Civil(day);
+  return O3_MONTH_START[1][c.month - 1] + c.day - 1;
+}
+
+// Days since 1970-01-01, first to last inclusive
+struct O3DayRange {
+  int32_t first, last;
+};
+
+// Every day of year
+constexpr O3DayRange o3YearRange(int year) {
+  return {o3DaysFromCivil(year, 1, 1), o3DaysFromCivil(year, 12, 31)};
+}
+
+// Date from its digit fields (e.g. "2005", "01", "01" of a file name);
+// false unless they form a valid date
+inline bool o3ParseCivil(std::string_view y, std::string_view m,
+                         std::string_view d, int32_t &day) {
+  int year = 0, month = 0, mday = 0;
+  auto digits = [](std::string_view text, int &value) {
+    const auto [last, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && last == text.data() + text.size();
+  };
+  if (!digits(y, year) || !digits(m, month) || !digits(d, mday) ||
+      year <= 0 || month < 1 || month > 12 || mday < 1 ||
+      mday > o3DaysInMonth(year, month))
+    return false;
+  day = o3DaysFromCivil(year, month, mday);
+  return true;
+}
+
+static_assert(o3DaysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(o3DaysFromCivil(2005, 1, 1) == 12784, "days_from_civil");
+static_assert(o3Civil(12784 + 59).month == 3, "civil_from_days");
+static_assert(o3DayOfYear(o3DaysFromCivil(2024, 12, 31)) == 366, "leap");
+static_assert(o3LeapSlot(o3DaysFromCivil(2023, 3, 1)) ==
+                  o3LeapSlot(o3DaysFromCivil(2024, 3, 1)),
+              "leap slots");
+static_assert(o3MonthOfDayOfYear(60, false) == 3, "month of day of year");
+
+#endif
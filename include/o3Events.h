@@ -0,0 +1,141 @@
+// o3Events.h
+// Machine-readable progress channel: one JSON object per line on a file
+// descriptor given with --events-fd=N (a pipe, socket or file), next to
+// the human log on stdout.
+//
+//   {"event":"task_end","time":1718000000.125,"location":"LAT0LON0",...}
+//
+// Every event has "event" and "time" (unix seconds); the other fields
+// depend on the event (see the README). Lines are written with a single
+// write() each, so events of concurrent workers never interleave.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3EVENTS_H
+#define O3EVENTS_H
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+class O3Event {
+private:
+  std::string text;
+
+  void key(const char *name) {
+    text += ",\"";
+    text += name;
+    text += "\":";
+  }
+
+public:
+  explicit O3Event(const char *type) {
+    const double now = std::chrono::duration<double>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+    char head[96];
+    std::snprintf(head, sizeof(head), "{\"event\":\"%s\",\"time\":%.3f", type,
+                  now);
+    text = head;
+  }
+
+  O3Event &str(const char *name, const std::string &value) {
+    key(name);
+    text += '"';
+    for (char c : value) {
+      if (c == '"' || c == '\\') {
+        text += '\\';
+        text += c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char esc[8];
+        std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+        text += esc;
+      } else {
+        text += c;
+      }
+    }
+    text += '"';
+    return *this;
+  }
+
+  O3Event &num(const char *name, double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", value);
+    key(name);
+    text += buf;
+    return *this;
+  }
+
+  O3Event &count(const char *name, uint64_t value) {
+    key(name);
+    text += std::to_string(value);
+    return *this;
+  }
+
+  O3Event &flag(const char *name, bool value) {
+    key(name);
+    text += value ? "true" : "false";
+    return *this;
+  }
+
+  std::string line() const { return text + "}\n"; }
+};
+
+class O3EventSink {
+private:
+  int fd = -1;
+  std::mutex mutex;
+
+public:
+  // Uses an already open descriptor; false if it is not open. The stage
+  // executables and the fit do not inherit it.
+  bool open(int eventsFd) {
+    if (eventsFd < 0 || ::fcntl(eventsFd, F_GETFD) < 0)
+      return false;
+    ::fcntl(eventsFd, F_SETFD, FD_CLOEXEC);
+    // A reader that goes away must not kill the run
+    std::signal(SIGPIPE, SIG_IGN);
+    fd = eventsFd;
+    return true;
+  }
+
+  bool enabled() const { return fd >= 0; }
+
+  // Writes one line; the channel is dropped if the reader has gone
+  void emit(const O3Event &event) {
+    if (fd < 0)
+      return;
+    const std::string line = event.line();
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t sent = 0;
+    while (fd >= 0 && sent < line.size()) {
+      const ssize_t n = ::write(fd, line.data() + sent, line.size() - sent);
+      if (n > 0)
+        sent += static_cast<size_t>(n);
+      else if (n < 0 && errno != EINTR)
+        fd = -1;
+    }
+  }
+};
+
+// Bytes this process has read so far (rchar of /proc/self/io: files,
+// pipes and sockets, page cache hits included); 0 if unavailable
+inline uint64_t o3ProcessBytesRead() {
+  std::ifstream in("/proc/self/io");
+  std::string name;
+  uint64_t value;
+  while (in >> name >> value) {
+    if (name == "rchar:")
+      return value;
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,200 @@
+// o3ExtractCache.h
+// On-disk cache of extracted source bins, shared by every run that points
+// at the same cache directory (--cache-dir=<dir>, -C<dir> for aprobe and
+// nmprobe).
+//
+// An entry holds the series one source bin (o3SourceBin) gives, so a 5
+// degree run reuses the points of an earlier 10 degree run and a rerun
+// reads no satellite file at all. Entries are keyed by (source, bin) and
+// stamped with the fingerprint of that source's data files (names, sizes,
+// mtimes, o3ScanSources); when the files change the stamp no longer
+// matches and the bin is extracted again and replaced.
+//
+//   <dir>/<source>/<lat bin>/<key>.o3x
+//
+// File layout (native endianness):
+//   O3ExtractCacheHeader
+//   per year: int32 year, uint32 n, n x O3DailyValue (int32 day, float)
+//
+// Entries are written under a temporary name and renamed into place, so
+// concurrent runs may share a cache directory.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3EXTRACTCACHE_H
+#define O3EXTRACTCACHE_H
+
+#include "o3Pipeline.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Bump when the extractors change what they return for the same files
+constexpr uint32_t O3_EXTRACT_CACHE_VERSION = 2;
+
+struct O3ExtractCacheHeader {
+  char magic[8]; // "O3XCACHE"
+  uint32_t version;
+  uint32_t years;
+  uint64_t key;
+  uint64_t fingerprint;
+};
+
+static_assert(sizeof(O3DailyValue) == 8, "cache rows are int32 day, float");
+
+class O3ExtractCache {
+private:
+  std::string dir;
+  uint64_t fingerprints[4];
+  std::atomic<size_t> hits{0}, misses{0}, tmpCounter{0};
+
+  static const char *sourceName(O3Source source) {
+    switch (source) {
+    case O3Source::OMI:
+      return "omi";
+    case O3Source::Nimbus7:
+      return "nimbus7";
+    case O3Source::Meteor3:
+      return "meteor3";
+    case O3Source::EarthProbe:
+      return "earthprobe";
+    }
+    return "unknown";
+  }
+
+  std::string entryPath(O3Source source, uint64_t key) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%06llx/%016llx.o3x",
+                  static_cast<unsigned long long>((key >> 24) & 0xFFFFFF),
+                  static_cast<unsigned long long>(key));
+    return dir + "/" + sourceName(source) + name;
+  }
+
+  bool load(const std::string &path, uint64_t key, uint64_t fingerprint,
+            O3LocationSeries &series) const {
+    std::ifstream in(path, std::ios::binary);
+    O3ExtractCacheHeader head;
+    if (!in.read(reinterpret_cast<char *>(&head), sizeof(head)) ||
+        std::memcmp(head.magic, "O3XCACHE", 8) != 0 ||
+        head.version != O3_EXTRACT_CACHE_VERSION || head.key != key ||
+        head.fingerprint != fingerprint)
+      return false;
+
+    O3LocationSeries loaded;
+    for (uint32_t y = 0; y < head.years; ++y) {
+      int32_t year;
+      uint32_t n;
+      if (!in.read(reinterpret_cast<char *>(&year), sizeof(year)) ||
+          !in.read(reinterpret_cast<char *>(&n), sizeof(n)) || n > 366)
+        return false;
+      std::vector<O3DailyValue> &rows = loaded[year];
+      rows.resize(n);
+      if (!in.read(reinterpret_cast<char *>(rows.data()),
+                   n * sizeof(O3DailyValue)))
+        return false;
+    }
+    // A truncated or overlong file is not used
+    if (in.peek() != std::char_traits<char>::eof())
+      return false;
+    for (auto &[year, values] : loaded)
+      series[year] = std::move(values);
+    return true;
+  }
+
+  bool store(const std::string &path, uint64_t key, uint64_t fingerprint,
+             const O3LocationSeries &series) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    const std::string tmpName = path + ".tmp" + std::to_string(::getpid()) +
+                                "_" + std::to_string(tmpCounter++);
+    {
+      std::ofstream out(tmpName, std::ios::binary);
+      O3ExtractCacheHeader head{};
+      std::memcpy(head.magic, "O3XCACHE", 8);
+      head.version = O3_EXTRACT_CACHE_VERSION;
+      head.years = static_cast<uint32_t>(series.size());
+      head.key = key;
+      head.fingerprint = fingerprint;
+      out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+      for (const auto &[year, values] : series) {
+        const int32_t y = year;
+        const uint32_t n = static_cast<uint32_t>(values.size());
+        out.write(reinterpret_cast<const char *>(&y), sizeof(y));
+        out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+        out.write(reinterpret_cast<const char *>(values.data()),
+                  n * sizeof(O3DailyValue));
+      }
+      if (!out) {
+        out.close();
+        std::remove(tmpName.c_str());
+        return false;
+      }
+    }
+    fs::rename(tmpName, path, ec);
+    if (ec) {
+      std::remove(tmpName.c_str());
+      return false;
+    }
+    return true;
+  }
+
+public:
+  // Creates cacheDir if needed and fingerprints the sources under dataPath;
+  // throws if the directory cannot be created
+  O3ExtractCache(const std::string &cacheDir, const std::string &dataPath)
+      : dir(cacheDir) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (!std::filesystem::is_directory(dir))
+      throw std::runtime_error("Cannot create extraction cache: " + dir);
+    O3SourceFiles files[4];
+    o3ScanSources(dataPath, files);
+    for (int s = 0; s < 4; ++s)
+      fingerprints[s] = files[s].fingerprint;
+  }
+
+  const std::string &directory() const { return dir; }
+
+  // Adds the years of the bin to series from the cache, or runs extract
+  // and stores its result. False if the extraction failed.
+  bool get(O3Source source, uint64_t key,
+           const std::function<bool(O3LocationSeries &)> &extract,
+           O3LocationSeries &series) {
+    const std::string path = entryPath(source, key);
+    const uint64_t fingerprint = fingerprints[static_cast<int>(source)];
+    if (load(path, key, fingerprint, series)) {
+      ++hits;
+      return true;
+    }
+
+    ++misses;
+    O3LocationSeries fresh;
+    if (!extract(fresh))
+      return false;
+    if (!store(path, key, fingerprint, fresh)) {
+      std::cerr << "Cannot write extraction cache entry: " << path
+                << std::endl;
+    }
+    for (auto &[year, values] : fresh)
+      series[year] = std::move(values);
+    return true;
+  }
+
+  void printSummary(std::ostream &out) const {
+    out << "Extraction cache " << dir << ": " << hits << " bins reused, "
+        << misses << " extracted" << std::endl;
+  }
+};
+
+#endif
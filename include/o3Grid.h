@@ -0,0 +1,97 @@
+// o3Grid.h
+// Regular lat/lon grid descriptor and compact integer cell IDs.
+//
+// A cell ID is iLat * nLon + iLon. IDs index result arrays, store offsets
+// and task lists directly; the "LAT<lat>LON<lon>" strings used for folder
+// and file names are only generated at the edges (file names, display).
+//
+// Header only and ROOT-free (usable from macros and compiled tools).
+
+#ifndef O3GRID_H
+#define O3GRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using O3CellId = int32_t;
+
+struct O3Grid {
+  double latMin = -90, lonMin = -180, step = 1;
+  int nLat = 0, nLon = 0;
+
+  O3Grid() = default;
+
+  // Inclusive bounds, as in the grid loops of the processor
+  O3Grid(double latMin, double latMax, double lonMin, double lonMax,
+         double step)
+      : latMin(latMin), lonMin(lonMin), step(step),
+        nLat(static_cast<int>(std::floor((latMax - latMin) / step + 1e-9)) + 1),
+        nLon(static_cast<int>(std::floor((lonMax - lonMin) / step + 1e-9)) +
+             1) {}
+
+  int size() const { return nLat * nLon; }
+
+  O3CellId cellId(int iLat, int iLon) const { return iLat * nLon + iLon; }
+  int latIndex(O3CellId id) const { return id / nLon; }
+  int lonIndex(O3CellId id) const { return id % nLon; }
+
+  double latOf(O3CellId id) const { return latMin + latIndex(id) * step; }
+  double lonOf(O3CellId id) const { return lonMin + lonIndex(id) * step; }
+
+  bool contains(double lat, double lon) const {
+    const double eps = 1e-9 * step;
+    return lat >= latMin - eps && lon >= lonMin - eps &&
+           lat <= latMin + (nLat - 1) * step + eps &&
+           lon <= lonMin + (nLon - 1) * step + eps;
+  }
+
+  // Nearest cell, clamped to the grid
+  O3CellId cellOf(double lat, double lon) const {
+    long iLat = std::lround((lat - latMin) / step);
+    long iLon = std::lround((lon - lonMin) / step);
+    iLat = iLat < 0 ? 0 : (iLat >= nLat ? nLat - 1 : iLat);
+    iLon = iLon < 0 ? 0 : (iLon >= nLon ? nLon - 1 : iLon);
+    return cellId(static_cast<int>(iLat), static_cast<int>(iLon));
+  }
+
+  // "LAT<lat>LON<lon>", integers without decimals (LAT-10LON20) as the
+  // processor always named them
+  std::string name(O3CellId id) const {
+    return cellName(latOf(id), lonOf(id));
+  }
+
+  static std::string cellName(double lat, double lon) {
+    return "LAT" + formatCoord(lat) + "LON" + formatCoord(lon);
+  }
+
+  static std::string formatCoord(double v) {
+    char buf[32];
+    const double r = std::round(v);
+    if (std::fabs(v - r) < 1e-9)
+      std::snprintf(buf, sizeof(buf), "%ld", static_cast<long>(r));
+    else
+      std::snprintf(buf, sizeof(buf), "%.6g", v);
+    return buf;
+  }
+};
+
+// Parses "LAT<lat>LON<lon>" (optionally prefixed, e.g. "skim_"); false if
+// the name does not contain one
+inline bool o3ParseCellName(const char *name, double &lat, double &lon) {
+  const char *p = std::strstr(name, "LAT");
+  if (!p)
+    return false;
+  char *end;
+  lat = std::strtod(p + 3, &end);
+  if (end == p + 3 || std::strncmp(end, "LON", 3) != 0)
+    return false;
+  const char *q = end + 3;
+  lon = std::strtod(q, &end);
+  return end != q;
+}
+
+#endif
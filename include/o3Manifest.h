@@ -0,0 +1,158 @@
+// o3Manifest.h
+// Append-only run manifest: one line per location event, so a crashed or
+// cancelled grid run can be resumed without redoing finished locations.
+//
+//   <location> <status> <input fingerprint> <output checksum> <output bytes>
+//   <seconds> <unix time>                              (tab separated)
+//
+// status is "start", "done", "failed" or "cancelled" (stopped by SIGINT or
+// SIGTERM); the last line of a location wins.
+// A torn last line from a crash is ignored when the manifest is loaded.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3MANIFEST_H
+#define O3MANIFEST_H
+
+#include "o3Archive.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Default manifest name in the run directory
+constexpr const char *O3_MANIFEST_NAME = "run.manifest";
+
+struct O3ManifestRecord {
+  std::string status;
+  uint64_t input = 0;
+  uint64_t output = 0;
+  uint64_t outputBytes = 0;
+  double seconds = 0;
+};
+
+// FNV-1a of a file's contents; 0 if it cannot be read
+inline uint64_t o3FileChecksum(const std::string &path,
+                               uint64_t *bytes = nullptr) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    return 0;
+  uint64_t h = 1469598103934665603ULL, n = 0;
+  char buf[1 << 16];
+  while (in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+    const std::streamsize got = in.gcount();
+    for (std::streamsize i = 0; i < got; ++i) {
+      h ^= static_cast<unsigned char>(buf[i]);
+      h *= 1099511628211ULL;
+    }
+    n += static_cast<uint64_t>(got);
+  }
+  if (bytes)
+    *bytes = n;
+  return h;
+}
+
+class O3Manifest {
+private:
+  int fd = -1;
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, O3ManifestRecord> last;
+
+  void load(const std::string &path) {
+    std::ifstream in(path);
+    std::string line;
+    char location[256], status[16];
+    O3ManifestRecord rec;
+    long long when;
+    while (std::getline(in, line)) {
+      if (std::sscanf(line.c_str(),
+                      "%255s %15s %" SCNx64 " %" SCNx64 " %" SCNu64 " %lf %lld",
+                      location, status, &rec.input, &rec.output,
+                      &rec.outputBytes, &rec.seconds, &when) != 7)
+        continue;
+      rec.status = status;
+      last[location] = rec;
+    }
+  }
+
+public:
+  explicit O3Manifest(const std::string &path = O3_MANIFEST_NAME) {
+    load(path);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open manifest: " + path);
+
+    // Terminate a line torn by a crash so the next record starts clean
+    char lastChar;
+    const off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size > 0 && ::pread(fd, &lastChar, 1, size - 1) == 1 &&
+        lastChar != '\n' && ::write(fd, "\n", 1) != 1)
+      throw std::runtime_error("Cannot write manifest: " + path);
+  }
+
+  ~O3Manifest() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  O3Manifest(const O3Manifest &) = delete;
+  O3Manifest &operator=(const O3Manifest &) = delete;
+
+  // Last recorded state of a location; false if never seen
+  bool find(const std::string &location, O3ManifestRecord &rec) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = last.find(location);
+    if (it == last.end())
+      return false;
+    rec = it->second;
+    return true;
+  }
+
+  // Last record of every location
+  std::vector<std::pair<std::string, O3ManifestRecord>> records() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {last.begin(), last.end()};
+  }
+
+  // Appends one line with a single write and flushes it to disk
+  void append(const std::string &location, const O3ManifestRecord &rec) {
+    char line[512];
+    const int n = std::snprintf(
+        line, sizeof(line),
+        "%s\t%s\t%016" PRIx64 "\t%016" PRIx64 "\t%" PRIu64 "\t%.3f\t%lld\n",
+        location.c_str(), rec.status.c_str(), rec.input, rec.output,
+        rec.outputBytes, rec.seconds,
+        static_cast<long long>(std::time(nullptr)));
+    std::lock_guard<std::mutex> lock(mutex);
+    if (n > 0 && ::write(fd, line, static_cast<size_t>(n)) == n)
+      ::fdatasync(fd);
+    last[location] = rec;
+  }
+
+  // True if the location finished with this input and its output is still
+  // there with the recorded size and checksum
+  bool isDone(const std::string &location, uint64_t input,
+              const std::string &outputPath) const {
+    O3ManifestRecord rec;
+    if (!find(location, rec) || rec.status != "done" || rec.input != input)
+      return false;
+    struct stat st;
+    uint64_t bytes = 0;
+    return ::stat(outputPath.c_str(), &st) == 0 &&
+           static_cast<uint64_t>(st.st_size) == rec.outputBytes &&
+           o3FileChecksum(outputPath, &bytes) == rec.output &&
+           bytes == rec.outputBytes;
+  }
+};
+
+#endif
@@ -0,0 +1,122 @@
+// o3Pipeline.h
+// In-process stages of the per-location pipeline, formerly the aprobe,
+// nmprobe, make_1995 and skim executables:
+//
+//   o3ExtractOMI    OMI/Aura daily HDF5 grids (2005-2024)
+//   o3ExtractTOMS   TOMS L3 text grids, Nimbus-7 / Meteor-3 / Earth Probe
+//   o3FillYear      placeholder year (1995 has no TOMS data)
+//   o3Skim          one value per calendar day, missing days marked -3
+//   o3FillGaps      days without satellite data (1995, or every gap of the
+//                   catalog): placeholder, linear or climatological values
+//
+// Stages exchange typed in-memory series; the writers produce the same
+// .dat files the executables did, each written under a temporary name and
+// renamed into place. Definitions are in o3Pipeline.cpp
+// (link with -lhdf5).
+
+#ifndef O3PIPELINE_H
+#define O3PIPELINE_H
+
+#include "o3Date.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Value markers of the .dat files (-3, a day missing from skim, is
+// O3_MISSING in o3Store.h)
+constexpr float O3_INVALID = -1.0f;     // satellite fill value
+constexpr float O3_PLACEHOLDER = -2.0f; // year without satellite data
+
+struct O3DailyValue {
+  int32_t day; // days since 1970-01-01 (o3Date.h)
+  float value;
+};
+
+// Raw daily values of one location, per year in source file order
+using O3LocationSeries = std::map<int, std::vector<O3DailyValue>>;
+
+enum class O3TomsSatellite { Nimbus7 = 1, Meteor3 = 2, EarthProbe = 3 };
+
+// Every satellite source of a location (TOMS values as O3TomsSatellite)
+enum class O3Source { OMI = 0, Nimbus7 = 1, Meteor3 = 2, EarthProbe = 3 };
+
+// Key of the source grid cell a location reads. Locations with equal keys
+// get identical series from that source, e.g. LON180 and LON-180 (both
+// extractors wrap longitude into [-180, 180)) or nearby points of a fine
+// grid that fall in the same 1.25 degree TOMS bin.
+uint64_t o3SourceBin(O3Source source, float lat, float lon);
+
+struct O3SourceFiles {
+  size_t years = 0; // year folders with at least one file
+  size_t files = 0;
+  uint64_t bytes = 0;
+  uint64_t fingerprint = 0; // names, sizes and mtimes of the files
+};
+
+// Data files every extraction of each source reads, indexed by O3Source
+void o3ScanSources(const std::string &dataPath, O3SourceFiles files[4]);
+
+// Appends the OMI years found under <dataPath>/aura_<year>/. A year whose
+// folder is missing is kept as an empty entry. False if dataPath is not a
+// directory.
+bool o3ExtractOMI(const std::string &dataPath, float lat, float lon,
+                  O3LocationSeries &series);
+
+// Appends the years of one TOMS satellite (<sat>_<year>/L3*.txt)
+bool o3ExtractTOMS(const std::string &dataPath, float lat, float lon,
+                   O3TomsSatellite satellite, O3LocationSeries &series);
+
+// Every calendar day of year set to marker (replaces existing values)
+void o3FillYear(int year, float marker, O3LocationSeries &series);
+
+// Skim of a location: every calendar day of the years with data as one
+// day-indexed array, missing days O3_MISSING. values holds the days of
+// years[0], years[1], ... back to back (365 or 366 each).
+struct O3SkimSeries {
+  std::vector<int> years; // ascending
+  std::vector<float> values;
+  std::vector<uint8_t> filled; // 1: estimated by o3FillGaps; empty if none
+};
+
+// Dense daily series of the years with at least one value
+O3SkimSeries o3Skim(const O3LocationSeries &series);
+
+// Every day of the years of a skim, as yearly rows for o3WriteYearFiles
+O3LocationSeries o3SkimYears(const O3SkimSeries &skim);
+
+// Days with no data file in any source, between the first and last day
+// of the catalog under dataPath (1995, missing days, instrument outages)
+std::vector<O3DayRange> o3CatalogGaps(const std::string &dataPath);
+
+// How o3FillGaps sets the days of a gap
+enum class O3GapFill {
+  Marker,      // the marker (O3_PLACEHOLDER), as make_1995 always did
+  Linear,      // straight line between the nearest valid days around it
+  Climatology, // mean of the same calendar day over the other years
+};
+
+// "marker", "linear" or "climatology"
+bool o3ParseGapFill(const std::string &text, O3GapFill &mode);
+
+// Sets every day of the gaps in one pass, adding the years they touch.
+// Estimated days (Linear, Climatology) are flagged in skim.filled; a day
+// with nothing to estimate from gets the marker. Returns the number of
+// estimated days.
+size_t o3FillGaps(O3SkimSeries &skim, const std::vector<O3DayRange> &gaps,
+                  O3GapFill mode, float marker = O3_PLACEHOLDER);
+
+// <dir>/<location>_<year>.dat, one file per year of the series
+bool o3WriteYearFiles(const std::string &dir, const std::string &location,
+                      const O3LocationSeries &series);
+
+// Reads back the <location>_<year>.dat files of dir
+bool o3ReadYearFiles(const std::string &dir, const std::string &location,
+                     O3LocationSeries &series);
+
+// skim_<location>/<location>.dat, written in one piece; estimated days are
+// listed (day, month, year) in skim_<location>/<location>_filled.dat
+bool o3WriteSkim(const std::string &location, const O3SkimSeries &skim);
+
+#endif
@@ -0,0 +1,258 @@
+// o3Plan.h
+// Dry-run estimate of a processor run: locations, source files, bytes read,
+// tasks, wall time, peak RAM and disk, computed without extracting anything.
+//
+// The inputs are the location list, the data file catalog (o3ScanSources)
+// and a calibration in seconds per unit of location cost (o3LocationCost).
+// The calibration comes from the done records of earlier runs in the
+// manifest, or from timing one extraction when there is no history.
+//
+// The model assumes extraction is the bottleneck: every unique source bin
+// is read once (O3SourceCache), the extract workers share the work evenly,
+// and skim runs behind them. Memory counts the series held in the source
+// cache and in the stage queues; disk counts the skim files and, when they
+// are written, the yearly files.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3PLAN_H
+#define O3PLAN_H
+
+#include "o3Grid.h"
+#include "o3Manifest.h"
+#include "o3Pipeline.h"
+#include "o3Region.h"
+#include "o3Shard.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Bytes an OMI extraction reads from one file (a chunk and the metadata of
+// the column-amount dataset, not the whole grid)
+constexpr uint64_t O3_PLAN_OMI_READ = 64 * 1024;
+
+// Approximate .dat bytes per line ("dd\tmm\tyyyy\tvalue\n")
+constexpr uint64_t O3_PLAN_LINE_BYTES = 18;
+
+// File system allocation unit
+constexpr uint64_t O3_PLAN_BLOCK = 4096;
+
+struct O3PlanEstimate {
+  size_t locations = 0;
+  size_t requests[4] = {0, 0, 0, 0}; // source bins read, indexed by O3Source
+  size_t unique[4] = {0, 0, 0, 0};   // distinct source bins
+  uint64_t bytesRead = 0;
+  size_t processes = 0; // stage executables with --external-tools
+  double workSeconds = 0;
+  double wallSeconds = 0;
+  uint64_t peakRamBytes = 0;
+  uint64_t diskBytes = 0;
+};
+
+// Seconds per unit of location cost from the done records of a manifest
+// whose names are grid cells; returns the number of records used
+inline size_t o3CalibrateFromManifest(const O3Manifest &manifest,
+                                      double &secondsPerUnit) {
+  double seconds = 0, units = 0;
+  size_t used = 0;
+  for (const auto &[name, rec] : manifest.records()) {
+    double lat, lon;
+    if (rec.status != "done" || rec.seconds <= 0 ||
+        !o3ParseCellName(name.c_str(), lat, lon))
+      continue;
+    seconds += rec.seconds;
+    units += o3LocationCost(lat);
+    ++used;
+  }
+  if (used > 0)
+    secondsPerUnit = seconds / units;
+  return used;
+}
+
+// Average skim size of the done records; 0 without history
+inline uint64_t o3AverageSkimBytes(const O3Manifest &manifest) {
+  uint64_t bytes = 0, n = 0;
+  for (const auto &[name, rec] : manifest.records()) {
+    if (rec.status == "done" && rec.outputBytes > 0) {
+      bytes += rec.outputBytes;
+      ++n;
+    }
+  }
+  return n > 0 ? bytes / n : 0;
+}
+
+// shareSources: bins are read once per run (in process) rather than once
+// per location (external tools). yearFiles: the yearly .dat files are
+// written too. skimBytes 0 estimates the skim size from the catalog years.
+inline O3PlanEstimate o3EstimatePlan(const std::vector<O3Location> &locations,
+                                     const O3SourceFiles files[4],
+                                     double secondsPerUnit, int ioWorkers,
+                                     int cpuWorkers, bool shareSources,
+                                     bool yearFiles, uint64_t skimBytes = 0) {
+  O3PlanEstimate est;
+  est.locations = locations.size();
+  est.processes = locations.size() * 6; // aprobe, nmprobe x3, make_1995, skim
+
+  // Task index of the first and last use of every source bin
+  struct Use {
+    size_t first, last, count;
+    int source;
+    double lat;
+  };
+  std::unordered_map<uint64_t, Use> uses;
+  double cost = 0;
+  for (size_t i = 0; i < locations.size(); ++i) {
+    const O3Location &loc = locations[i];
+    cost += o3LocationCost(loc.lat);
+    for (int s = 0; s < 4; ++s) {
+      const uint64_t key =
+          o3SourceBin(static_cast<O3Source>(s), static_cast<float>(loc.lat),
+                      static_cast<float>(loc.lon));
+      ++est.requests[s];
+      auto it = uses.find(key);
+      if (it == uses.end()) {
+        uses.emplace(key, Use{i, i, 1, s, loc.lat});
+      } else {
+        it->second.last = i;
+        ++it->second.count;
+      }
+    }
+  }
+
+  size_t requests = 0, unique = 0;
+  for (const auto &[key, use] : uses) {
+    ++est.unique[use.source];
+    const O3SourceFiles &f = files[use.source];
+    const uint64_t reads = shareSources ? 1 : use.count;
+    if (use.source == static_cast<int>(O3Source::OMI)) {
+      const uint64_t perFile = f.files > 0 ? f.bytes / f.files : 0;
+      est.bytesRead += reads * f.files * std::min(perFile, O3_PLAN_OMI_READ);
+    } else {
+      // TOMS files are scanned up to the latitude band, south to north
+      est.bytesRead += reads * static_cast<uint64_t>(
+          f.bytes * (o3LocationCost(use.lat) - 1.0));
+    }
+  }
+  for (int s = 0; s < 4; ++s) {
+    requests += est.requests[s];
+    unique += est.unique[s];
+  }
+
+  const int io = std::max(1, ioWorkers);
+  const int cpu = std::max(1, cpuWorkers);
+  const double shared = shareSources && requests > 0
+                            ? static_cast<double>(unique) / requests
+                            : 1.0;
+  est.workSeconds = secondsPerUnit * cost * shared;
+  const size_t parallel =
+      std::max<size_t>(1, std::min<size_t>(io, locations.size()));
+  est.wallSeconds = est.workSeconds / parallel;
+
+  // Cache entries live from their first use until io tasks after their
+  // last one (the workers run about io tasks at a time)
+  std::vector<std::pair<size_t, int64_t>> events;
+  for (const auto &[key, use] : uses) {
+    const int64_t bytes = static_cast<int64_t>(files[use.source].files *
+                                               sizeof(O3DailyValue));
+    events.emplace_back(2 * use.first, bytes);
+    events.emplace_back(2 * (use.last + io) + 1, -bytes);
+  }
+  if (!shareSources)
+    events.clear(); // each location extracts into its own series
+  std::sort(events.begin(), events.end());
+  int64_t held = 0, peak = 0;
+  for (const auto &event : events) {
+    held += event.second;
+    peak = std::max(peak, held);
+  }
+
+  size_t allFiles = 0, years = 0;
+  for (int s = 0; s < 4; ++s) {
+    allFiles += files[s].files;
+    years += files[s].years;
+  }
+  const uint64_t seriesBytes = (allFiles + 366) * sizeof(O3DailyValue);
+  // Series being extracted; skim arrays queued (2 per skim worker) and
+  // being written
+  const uint64_t skimArray =
+      static_cast<uint64_t>((years + 1) * 366 * sizeof(float));
+  const uint64_t inFlight = io * seriesBytes + 3 * cpu * skimArray;
+  est.peakRamBytes = static_cast<uint64_t>(peak) + inFlight;
+
+  // Yearly files (1995 is a full placeholder year) and their folder, the
+  // skim and its folder, each rounded up to whole file system blocks
+  auto blocks = [](uint64_t bytes) {
+    return (bytes + O3_PLAN_BLOCK - 1) / O3_PLAN_BLOCK * O3_PLAN_BLOCK;
+  };
+  const uint64_t yearCount = years + 1;
+  if (skimBytes == 0)
+    skimBytes = static_cast<uint64_t>(yearCount * 365.25 *
+                                      (O3_PLAN_LINE_BYTES - 1));
+  const uint64_t yearBytes = (allFiles + 365) * O3_PLAN_LINE_BYTES;
+  est.diskBytes =
+      locations.size() *
+      ((yearFiles ? yearCount * blocks(yearBytes / yearCount) + O3_PLAN_BLOCK
+                  : 0) +
+       blocks(skimBytes) + O3_PLAN_BLOCK);
+  return est;
+}
+
+// Human readable byte count (B, KiB, ... TiB)
+inline void o3PrintBytes(std::ostream &out, uint64_t bytes) {
+  const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double value = static_cast<double>(bytes);
+  int u = 0;
+  while (value >= 1024 && u < 4) {
+    value /= 1024;
+    ++u;
+  }
+  out << std::fixed << std::setprecision(u == 0 ? 0 : 1) << value << " "
+      << units[u];
+}
+
+inline void o3PrintPlan(std::ostream &out, const O3PlanEstimate &est,
+                        const O3SourceFiles files[4], bool externalTools) {
+  const char *names[] = {"OMI", "Nimbus-7", "Meteor-3", "Earth Probe"};
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+
+  out << "Locations to process: " << est.locations << std::endl;
+  out << "Source files:" << std::endl;
+  size_t unique = 0, requests = 0;
+  for (int s = 0; s < 4; ++s) {
+    out << "  " << std::left << std::setw(12) << names[s] << std::right
+        << files[s].files << " files in " << files[s].years << " years, ";
+    o3PrintBytes(out, files[s].bytes);
+    out << "; " << est.unique[s] << " bins for " << est.requests[s]
+        << " locations" << std::endl;
+    unique += est.unique[s];
+    requests += est.requests[s];
+  }
+  out << "Estimated bytes read: ";
+  o3PrintBytes(out, est.bytesRead);
+  out << std::endl;
+  if (externalTools)
+    out << "Processes: " << est.processes << " stage executables"
+        << std::endl;
+  else
+    out << "Tasks: " << est.locations << " locations, " << unique
+        << " extractions for " << requests << " source reads" << std::endl;
+  out << "Estimated work: " << std::fixed << std::setprecision(1)
+      << est.workSeconds << " s, wall time: " << est.wallSeconds << " s ("
+      << est.wallSeconds / 3600 << " h)" << std::endl;
+  out << "Peak RAM: ";
+  o3PrintBytes(out, est.peakRamBytes);
+  out << ", disk: ";
+  o3PrintBytes(out, est.diskBytes);
+  out << std::endl;
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+#endif
@@ -0,0 +1,139 @@
+// o3Priority.h
+// Processing order of a location list, so a region of interest finishes
+// (and is fitted) first while the rest of the globe follows.
+//
+//   --focus=<lat>,<lon>                       nearest to a point first
+//   --focus=<latMin>,<latMax>,<lonMin>,<lonMax>   inside a box first, then
+//                                             by distance to the box
+//   --priority-file=<path>                    listed names first, in file
+//                                             order ('#' starts a comment)
+//
+// Listed names come before the focus order; locations with equal priority
+// keep their original order. Reordering never changes which locations a
+// shard gets (o3Shard.h partitions the original list).
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3PRIORITY_H
+#define O3PRIORITY_H
+
+#include "o3Region.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct O3Focus {
+  double latMin = 0, latMax = 0; // a point has latMin == latMax
+  double lonMin = 0, lonMax = 0;
+};
+
+// "lat,lon" or "latMin,latMax,lonMin,lonMax"
+inline bool o3ParseFocus(const std::string &text, O3Focus &focus) {
+  double v[4];
+  char tail;
+  const int n = std::sscanf(text.c_str(), "%lf,%lf,%lf,%lf%c", &v[0], &v[1],
+                            &v[2], &v[3], &tail);
+  if (n == 2 && std::fabs(v[0]) <= 90 && std::fabs(v[1]) <= 180) {
+    focus = {v[0], v[0], v[1], v[1]};
+    return true;
+  }
+  if (n == 4 && v[0] <= v[1] && v[2] <= v[3] && v[0] >= -90 && v[1] <= 90 &&
+      v[2] >= -180 && v[3] <= 180) {
+    focus = {v[0], v[1], v[2], v[3]};
+    return true;
+  }
+  return false;
+}
+
+// Great-circle distance in km
+inline double o3DistanceKm(double lat1, double lon1, double lat2,
+                           double lon2) {
+  const double rad = 3.14159265358979323846 / 180.0;
+  const double dLat = (lat2 - lat1) * rad, dLon = (lon2 - lon1) * rad;
+  const double a = std::sin(dLat / 2) * std::sin(dLat / 2) +
+                   std::cos(lat1 * rad) * std::cos(lat2 * rad) *
+                       std::sin(dLon / 2) * std::sin(dLon / 2);
+  return 2 * 6371.0 * std::asin(std::sqrt(std::min(1.0, a)));
+}
+
+// Distance to the focus point, or to the nearest point of the box (0 inside)
+inline double o3FocusDistance(const O3Focus &focus, double lat, double lon) {
+  const double nearLat = std::min(focus.latMax, std::max(focus.latMin, lat));
+  double nearLon = lon;
+  if (lon < focus.lonMin || lon > focus.lonMax) {
+    // Closest box edge, across the antimeridian if that is shorter
+    auto gap = [](double a, double b) {
+      const double d = std::fabs(a - b);
+      return std::min(d, 360.0 - d);
+    };
+    nearLon = gap(lon, focus.lonMin) <= gap(lon, focus.lonMax) ? focus.lonMin
+                                                               : focus.lonMax;
+  }
+  return o3DistanceKm(lat, lon, nearLat, nearLon);
+}
+
+// Names of a priority file, mapped to their rank (0 first)
+inline bool o3ReadPriorityFile(const std::string &path,
+                               std::unordered_map<std::string, size_t> &ranks,
+                               std::string &error) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    error = "Cannot open priority file: " + path;
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    const size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+    const size_t b = line.find_first_not_of(" \t\r");
+    if (b == std::string::npos)
+      continue;
+    const size_t e = line.find_last_not_of(" \t\r");
+    ranks.emplace(line.substr(b, e - b + 1), ranks.size());
+  }
+  return true;
+}
+
+// Stable reorder: ranked names first (by rank), then by focus distance
+inline void o3PrioritizeLocations(
+    std::vector<O3Location> &locations, const O3Focus *focus,
+    const std::unordered_map<std::string, size_t> *ranks) {
+  const size_t unranked = std::numeric_limits<size_t>::max();
+  std::vector<size_t> rank(locations.size(), unranked);
+  std::vector<double> distance(locations.size(), 0.0);
+  for (size_t i = 0; i < locations.size(); ++i) {
+    if (ranks) {
+      auto it = ranks->find(locations[i].name);
+      if (it != ranks->end())
+        rank[i] = it->second;
+    }
+    if (focus)
+      distance[i] =
+          o3FocusDistance(*focus, locations[i].lat, locations[i].lon);
+  }
+
+  std::vector<size_t> order(locations.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (rank[a] != rank[b])
+      return rank[a] < rank[b];
+    return distance[a] < distance[b];
+  });
+
+  std::vector<O3Location> sorted;
+  sorted.reserve(locations.size());
+  for (size_t i : order)
+    sorted.push_back(std::move(locations[i]));
+  locations.swap(sorted);
+}
+
+#endif
@@ -0,0 +1,194 @@
+// o3Region.h
+// Location lists for the processor: regular grids over any lat/lon box and
+// CSV files of named points and polygons.
+//
+// CSV format (one entry per line, '#' starts a comment):
+//   BOG,4.36,-74.04                                  named point
+//   COL,polygon,0.5,12.5 -79,12.5 -66.8,-4.2 -66.8   polygon: step, then
+//                                                    "lat lon" vertices
+// A polygon expands to the cells of the step-aligned grid whose centre lies
+// inside it, named LAT<lat>LON<lon> like grid runs so results line up.
+// Names become directory names and stage executable arguments, so they are
+// limited to letters, digits, '_', '.' and '-'.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3REGION_H
+#define O3REGION_H
+
+#include "o3Grid.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+struct O3Location {
+  std::string name;
+  double lat, lon;
+};
+
+// Grid cells, longitude outer and latitude inner as the processor always
+// walked them
+inline std::vector<O3Location> o3GridLocations(const O3Grid &grid) {
+  std::vector<O3Location> out;
+  out.reserve(grid.size());
+  for (int iLon = 0; iLon < grid.nLon; ++iLon) {
+    for (int iLat = 0; iLat < grid.nLat; ++iLat) {
+      const O3CellId id = grid.cellId(iLat, iLon);
+      out.push_back({grid.name(id), grid.latOf(id), grid.lonOf(id)});
+    }
+  }
+  return out;
+}
+
+// Usable as a directory name and unquoted in a shell command
+inline bool o3ValidLocationName(const std::string &name) {
+  if (name.empty() || name == "." || name == "..")
+    return false;
+  for (char c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' &&
+        c != '.' && c != '-')
+      return false;
+  }
+  return true;
+}
+
+inline bool o3ValidPoint(double lat, double lon) {
+  return std::fabs(lat) <= 90 && std::fabs(lon) <= 180;
+}
+
+// Field without surrounding blanks
+inline std::string o3TrimField(const std::string &field) {
+  const size_t first = field.find_first_not_of(" \t\r");
+  if (first == std::string::npos)
+    return "";
+  return field.substr(first, field.find_last_not_of(" \t\r") - first + 1);
+}
+
+// Even-odd rule; vertices are (lat, lon)
+inline bool o3PointInPolygon(double lat, double lon,
+                             const std::vector<std::pair<double, double>> &poly) {
+  bool inside = false;
+  for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+    const double yi = poly[i].first, xi = poly[i].second;
+    const double yj = poly[j].first, xj = poly[j].second;
+    if ((yi > lat) != (yj > lat) &&
+        lon < (xj - xi) * (lat - yi) / (yj - yi) + xi)
+      inside = !inside;
+  }
+  return inside;
+}
+
+// Step-aligned cells inside the polygon
+inline void o3PolygonLocations(const std::vector<std::pair<double, double>> &poly,
+                               double step, std::vector<O3Location> &out) {
+  double latLo = 90, latHi = -90, lonLo = 180, lonHi = -180;
+  for (const auto &[lat, lon] : poly) {
+    latLo = std::min(latLo, lat);
+    latHi = std::max(latHi, lat);
+    lonLo = std::min(lonLo, lon);
+    lonHi = std::max(lonHi, lon);
+  }
+  const long iLat0 = std::lround(std::ceil(latLo / step - 1e-9));
+  const long iLat1 = std::lround(std::floor(latHi / step + 1e-9));
+  const long iLon0 = std::lround(std::ceil(lonLo / step - 1e-9));
+  const long iLon1 = std::lround(std::floor(lonHi / step + 1e-9));
+  for (long iLon = iLon0; iLon <= iLon1; ++iLon) {
+    for (long iLat = iLat0; iLat <= iLat1; ++iLat) {
+      const double lat = iLat * step, lon = iLon * step;
+      if (o3PointInPolygon(lat, lon, poly))
+        out.push_back({O3Grid::cellName(lat, lon), lat, lon});
+    }
+  }
+}
+
+// Appends the entries of a points/polygons CSV, skipping names already
+// listed. On a malformed line returns false with the line in error.
+inline bool o3ReadLocationsCsv(const std::string &path,
+                               std::vector<O3Location> &out,
+                               std::string &error) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    error = "Cannot open " + path;
+    return false;
+  }
+
+  std::unordered_set<std::string> seen;
+  for (const auto &loc : out)
+    seen.insert(loc.name);
+
+  std::vector<O3Location> found;
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    const size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ','))
+      fields.push_back(field);
+    if (fields.empty() || line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    const std::string where = path + ":" + std::to_string(lineNo) + ": ";
+    const std::string locName = o3TrimField(fields[0]);
+    if (!o3ValidLocationName(locName)) {
+      error = where + "invalid name '" + locName +
+              "' (letters, digits, '_', '.' and '-' only)";
+      return false;
+    }
+    bool ok = true, inRange = true;
+    found.clear();
+
+    if (fields.size() == 3) {
+      double lat, lon;
+      std::istringstream a(fields[1]), b(fields[2]);
+      ok = static_cast<bool>(a >> lat) && static_cast<bool>(b >> lon);
+      inRange = !ok || o3ValidPoint(lat, lon);
+      if (ok && inRange)
+        found.push_back({locName, lat, lon});
+    } else if (fields.size() >= 6 && o3TrimField(fields[1]) == "polygon") {
+      double step = 0;
+      std::istringstream s(fields[2]);
+      ok = static_cast<bool>(s >> step) && step > 0;
+      std::vector<std::pair<double, double>> poly;
+      for (size_t k = 3; ok && inRange && k < fields.size(); ++k) {
+        double lat, lon;
+        std::istringstream v(fields[k]);
+        ok = static_cast<bool>(v >> lat >> lon);
+        inRange = !ok || o3ValidPoint(lat, lon);
+        poly.emplace_back(lat, lon);
+      }
+      if (ok && inRange)
+        o3PolygonLocations(poly, step, found);
+    } else {
+      ok = false;
+    }
+
+    if (!inRange) {
+      error = where + "point outside |lat| <= 90, |lon| <= 180 in '" + line +
+              "'";
+      return false;
+    }
+    if (!ok) {
+      error = where + "cannot parse '" + line + "'";
+      return false;
+    }
+    for (auto &loc : found) {
+      if (seen.insert(loc.name).second)
+        out.push_back(std::move(loc));
+    }
+  }
+  return true;
+}
+
+#endif
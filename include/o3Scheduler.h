@@ -0,0 +1,138 @@
+// o3Scheduler.h
+// Work-stealing scheduler for per-location tasks.
+//
+// Every worker owns a deque of task indices, seeded round-robin so that
+// neighbouring (similarly expensive) locations land on different workers.
+// A worker pops from the front of its own deque; once it is empty it
+// steals from the back of the others, so no worker idles while tasks are
+// left anywhere. Tasks are coarse (seconds), so each deque is guarded by a
+// plain mutex.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3SCHEDULER_H
+#define O3SCHEDULER_H
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+struct O3WorkerStats {
+  size_t tasks = 0;   // tasks run by this worker
+  size_t stolen = 0;  // of which taken from another worker
+  double busySeconds = 0;
+};
+
+class O3Scheduler {
+private:
+  struct alignas(64) WorkerQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+  };
+
+  int numWorkers;
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<O3WorkerStats> workerStats;
+  double wall = 0;
+
+  bool popOwn(int w, size_t &task) {
+    WorkerQueue &q = *queues[w];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+      return false;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+  }
+
+  // Scans the other workers, starting after w, and takes from the back
+  bool steal(int w, size_t &task) {
+    for (int k = 1; k < numWorkers; ++k) {
+      WorkerQueue &q = *queues[(w + k) % numWorkers];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty()) {
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  explicit O3Scheduler(int numWorkers)
+      : numWorkers(numWorkers > 0 ? numWorkers : 1) {
+    for (int w = 0; w < this->numWorkers; ++w)
+      queues.emplace_back(new WorkerQueue);
+  }
+
+  int workers() const { return numWorkers; }
+
+  // Runs task(i, worker) for every i in [0, nTasks) and returns when all
+  // of them have finished. No tasks are added while running, so a worker
+  // that finds every deque empty is done.
+  void run(size_t nTasks, const std::function<void(size_t, int)> &task) {
+    for (size_t i = 0; i < nTasks; ++i)
+      queues[i % numWorkers]->tasks.push_back(i);
+    workerStats.assign(numWorkers, O3WorkerStats{});
+
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&](int w) {
+      O3WorkerStats &st = workerStats[w];
+      size_t i;
+      while (true) {
+        bool own = popOwn(w, i);
+        if (!own && !steal(w, i))
+          return;
+        auto t0 = std::chrono::steady_clock::now();
+        task(i, w);
+        st.busySeconds += std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count();
+        ++st.tasks;
+        if (!own)
+          ++st.stolen;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < numWorkers; ++w)
+      threads.emplace_back(worker, w);
+    for (auto &t : threads)
+      t.join();
+    wall = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count();
+  }
+
+  const std::vector<O3WorkerStats> &stats() const { return workerStats; }
+  double wallSeconds() const { return wall; }
+
+  // Busy time over wall time of the last run, per worker
+  double utilization(int w) const {
+    return wall > 0 ? workerStats[w].busySeconds / wall : 0;
+  }
+
+  void printUtilization(std::ostream &out) const {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << "Worker utilization over " << std::fixed << std::setprecision(1)
+        << wall << " s:" << std::endl;
+    for (int w = 0; w < numWorkers; ++w) {
+      out << "  worker " << w << ": " << std::setprecision(1)
+          << 100.0 * utilization(w) << "% busy, " << workerStats[w].tasks
+          << " tasks (" << workerStats[w].stolen << " stolen)" << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+  }
+};
+
+#endif
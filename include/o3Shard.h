@@ -0,0 +1,133 @@
+// o3Shard.h
+// Deterministic partition of a location list over N processes or machines
+// (--shard i/N, i from 1 to N).
+//
+// Every shard computes the same partition from the location list alone, so
+// no coordination is needed. Locations are balanced by an estimated cost
+// that depends only on latitude: a TOMS text file is scanned up to the
+// label of the latitude band, and bands are stored south to north, so
+// northern locations read about twice as many lines as southern ones. The
+// assignment is greedy longest-processing-time: most expensive first, each
+// to the least loaded shard, ties broken by position and shard number.
+//
+// Each shard writes its locations to shard.plan; ozone_merge uses the plans
+// to check that the merged result set is complete, and analysis_runner
+// --shard fits the locations of the plan in its directory.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3SHARD_H
+#define O3SHARD_H
+
+#include "o3Region.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr const char *O3_SHARD_PLAN_NAME = "shard.plan";
+
+struct O3Shard {
+  int index = 1; // 1..count
+  int count = 1;
+};
+
+// Parses "i/N" with 1 <= i <= N
+inline bool o3ParseShard(const std::string &text, O3Shard &shard) {
+  int i, n;
+  char tail;
+  if (std::sscanf(text.c_str(), "%d/%d%c", &i, &n, &tail) != 2 || n < 1 ||
+      i < 1 || i > n)
+    return false;
+  shard.index = i;
+  shard.count = n;
+  return true;
+}
+
+// Relative cost of a location (1 at the south pole, 2 at the north pole)
+inline double o3LocationCost(double lat) {
+  return 1.0 + (std::min(90.0, std::max(-90.0, lat)) + 90.0) / 180.0;
+}
+
+// Shard number (1..count) of every location
+inline std::vector<int> o3ShardAssignment(
+    const std::vector<O3Location> &locations, int count) {
+  std::vector<size_t> order(locations.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return o3LocationCost(locations[a].lat) > o3LocationCost(locations[b].lat);
+  });
+
+  std::vector<double> load(count, 0.0);
+  std::vector<int> shardOf(locations.size(), 1);
+  for (size_t i : order) {
+    const int s = static_cast<int>(
+        std::min_element(load.begin(), load.end()) - load.begin());
+    load[s] += o3LocationCost(locations[i].lat);
+    shardOf[i] = s + 1;
+  }
+  return shardOf;
+}
+
+// Keeps the locations of one shard, in their original order
+inline std::vector<O3Location> o3ShardLocations(
+    const std::vector<O3Location> &locations, const O3Shard &shard) {
+  const std::vector<int> shardOf = o3ShardAssignment(locations, shard.count);
+  std::vector<O3Location> out;
+  for (size_t i = 0; i < locations.size(); ++i) {
+    if (shardOf[i] == shard.index)
+      out.push_back(locations[i]);
+  }
+  return out;
+}
+
+// "# shard i/N" followed by one "<name>\t<lat>\t<lon>" line per location
+inline bool o3WriteShardPlan(const std::string &path, const O3Shard &shard,
+                             const std::vector<O3Location> &locations) {
+  std::ofstream out(path);
+  if (!out.is_open())
+    return false;
+  out << "# shard " << shard.index << "/" << shard.count << "\n";
+  char coords[64];
+  for (const auto &loc : locations) {
+    std::snprintf(coords, sizeof(coords), "\t%.6f\t%.6f", loc.lat, loc.lon);
+    out << loc.name << coords << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+inline bool o3ReadShardPlan(const std::string &path, O3Shard &shard,
+                            std::vector<O3Location> &locations) {
+  std::ifstream in(path);
+  std::string line;
+  if (!in.is_open() || !std::getline(in, line) ||
+      line.compare(0, 8, "# shard ") != 0 ||
+      !o3ParseShard(line.substr(8), shard))
+    return false;
+  while (std::getline(in, line)) {
+    if (line.empty())
+      continue;
+    O3Location loc;
+    std::istringstream fields(line);
+    if (!(fields >> loc.name >> loc.lat >> loc.lon))
+      return false;
+    locations.push_back(loc);
+  }
+  return true;
+}
+
+inline bool o3ReadShardPlan(const std::string &path, O3Shard &shard,
+                            std::vector<std::string> &names) {
+  std::vector<O3Location> locations;
+  if (!o3ReadShardPlan(path, shard, locations))
+    return false;
+  for (const auto &loc : locations)
+    names.push_back(loc.name);
+  return true;
+}
+
+#endif
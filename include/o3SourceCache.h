@@ -0,0 +1,110 @@
+// o3SourceCache.h
+// Extracts every satellite source bin once per run and hands the series to
+// all locations that read it (see o3SourceBin).
+//
+// The planner registers each location's bins before the run; the first
+// location to need a bin extracts it while later ones wait for the result,
+// and the entry is dropped once its last planned user has taken it. Grid
+// runs walk longitude columns in order, so only the bins of a few
+// neighbouring columns are held at a time.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3SOURCECACHE_H
+#define O3SOURCECACHE_H
+
+#include "o3Pipeline.h"
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+class O3SourceCache {
+private:
+  using Result = std::shared_ptr<const O3LocationSeries>;
+
+  struct Entry {
+    int uses = 0; // planned users not served yet
+    bool started = false;
+    std::shared_future<Result> result;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Entry> entries;
+  size_t requested = 0, extracted = 0;
+
+public:
+  // Registers one future use of a bin; call before the run starts
+  void plan(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++entries[key].uses;
+  }
+
+  // Adds the years of the bin to series, running extract only if no other
+  // location has done so. False if the extraction failed.
+  bool get(uint64_t key,
+           const std::function<bool(O3LocationSeries &)> &extract,
+           O3LocationSeries &series) {
+    std::promise<Result> promise;
+    std::shared_future<Result> result;
+    bool owner = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++requested;
+      auto it = entries.find(key);
+      if (it == entries.end()) {
+        // Not planned: nobody else will ask for it
+        ++extracted;
+        return extract(series);
+      }
+      if (!it->second.started) {
+        it->second.started = true;
+        it->second.result = promise.get_future().share();
+        owner = true;
+        ++extracted;
+      }
+      result = it->second.result;
+    }
+
+    if (owner) {
+      auto fresh = std::make_shared<O3LocationSeries>();
+      promise.set_value(extract(*fresh) ? fresh : nullptr);
+    }
+    const Result value = result.get();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      if (it != entries.end() && --it->second.uses <= 0)
+        entries.erase(it);
+    }
+
+    if (!value)
+      return false;
+    for (const auto &[year, rows] : *value)
+      series[year] = rows;
+    return true;
+  }
+
+  void printSummary(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << "Source bins: " << extracted << " extracted for " << requested
+        << " requests";
+    if (requested > 0) {
+      out << " (" << std::fixed << std::setprecision(1)
+          << 100.0 * (requested - extracted) / requested << "% saved)";
+    }
+    out << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+  }
+};
+
+#endif
@@ -0,0 +1,117 @@
+// o3Stages.h
+// Building blocks of the staged processor pipeline
+//
+//   extract (I/O) --queue--> skim (CPU) --queue--> fit (CPU, chi2 app)
+//
+// Stages run their own worker threads and hand items over through bounded
+// queues. A full queue blocks its producers, so a slow stage throttles the
+// ones before it and at most capacity items are held between two stages.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3STAGES_H
+#define O3STAGES_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+template <class T> class O3BoundedQueue {
+private:
+  std::mutex mutex;
+  std::condition_variable notFull, notEmpty;
+  std::deque<T> items;
+  size_t capacity;
+  int producers;
+  double waitPush = 0, waitPop = 0;
+
+  static double since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         t0)
+        .count();
+  }
+
+public:
+  // The queue closes once every producer has called done()
+  O3BoundedQueue(size_t capacity, int producers)
+      : capacity(capacity > 0 ? capacity : 1), producers(producers) {}
+
+  // Blocks while the queue is full
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (items.size() >= capacity) {
+      auto t0 = std::chrono::steady_clock::now();
+      notFull.wait(lock, [this] { return items.size() < capacity; });
+      waitPush += since(t0);
+    }
+    items.push_back(std::move(item));
+    notEmpty.notify_one();
+  }
+
+  // Blocks until an item arrives; false once the queue is closed and empty
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (items.empty() && producers > 0) {
+      auto t0 = std::chrono::steady_clock::now();
+      notEmpty.wait(lock, [this] { return !items.empty() || producers == 0; });
+      waitPop += since(t0);
+    }
+    if (items.empty())
+      return false;
+    item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  // Called by each producer when it has nothing more to push
+  void done() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (producers > 0 && --producers == 0)
+      notEmpty.notify_all();
+  }
+
+  // Thread-seconds producers spent blocked on a full queue (backpressure)
+  // and consumers spent waiting for input (starvation)
+  double pushWaitSeconds() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return waitPush;
+  }
+  double popWaitSeconds() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return waitPop;
+  }
+};
+
+struct O3StageStats {
+  std::string name;
+  int workers = 0;
+  size_t items = 0;
+  double busySeconds = 0; // summed over the stage's workers
+};
+
+inline void o3PrintStages(std::ostream &out, const O3StageStats *stages,
+                          int nStages, double wallSeconds) {
+  const std::ios::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << "Stage utilization over " << std::fixed << std::setprecision(1)
+      << wallSeconds << " s:" << std::endl;
+  for (int s = 0; s < nStages; ++s) {
+    const O3StageStats &st = stages[s];
+    const double capacity = st.workers * wallSeconds;
+    out << "  " << st.name << ": " << st.workers << " workers, " << st.items
+        << " items, "
+        << (capacity > 0 ? 100.0 * st.busySeconds / capacity : 0.0)
+        << "% busy" << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+#endif
@@ -0,0 +1,326 @@
+// o3Store.h
+// Dense, memory-mapped store of skimmed daily ozone series for a regular
+// lat/lon grid, with point queries (nearest cell or fill-aware bilinear).
+//
+// Layout (little endian):
+//   [0, 4096)        O3StoreHeader, zero padded
+//   [4096, ...)      float data[nLat * nLon][nDays], one contiguous series
+//                    per cell, indexed by the O3Grid cell ID
+//   [flagsOffset, ...) uint8 filled[nLat * nLon][nDays], gap-filled stores
+//                    only (o3StoreFill.h): 0 for an observed day, k for a
+//                    day estimated in place of the marker -k
+//
+// Values follow the .dat conventions: > 0 is total ozone in DU, -1 invalid
+// satellite value, -2 placeholder year (1995), -3 day missing from skim.
+//
+// Header only and free of ROOT dependencies so it can be used from the
+// command line tools and from ROOT macros alike:
+//   root [0] #include "include/o3Store.h"
+//   root [1] O3Store st("ozone.o3s");
+//   root [2] auto v = st.series(4.36, -74.04, o3DaysFromCivil(2005, 1, 1),
+//                               o3DaysFromCivil(2005, 12, 31));
+
+#ifndef O3STORE_H
+#define O3STORE_H
+
+#include "o3Date.h"
+#include "o3Grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Missing-day marker used by skim
+constexpr float O3_MISSING = -3.0f;
+
+enum class O3Interp { Nearest, Bilinear };
+
+struct O3StoreHeader {
+  char magic[8]; // "O3STORE1"
+  uint32_t version;
+  uint32_t dataOffset;
+  double latMin, lonMin, step;
+  int32_t nLat, nLon;
+  int32_t day0; // first day of the series, days since 1970-01-01
+  int32_t nDays;
+  uint64_t flagsOffset; // 0: no fill flags (stores before version 2)
+};
+
+constexpr uint32_t O3_STORE_DATA_OFFSET = 4096;
+
+// Builds a store file cell by cell. Cells never written stay O3_MISSING
+// (and unflagged, with fillFlags).
+class O3StoreWriter {
+private:
+  int fd = -1;
+  O3StoreHeader hdr{};
+
+public:
+  O3StoreWriter(const std::string &path, const O3Grid &grid, int32_t day0,
+                int32_t nDays, bool fillFlags = false) {
+    std::memcpy(hdr.magic, "O3STORE1", 8);
+    hdr.version = fillFlags ? 2 : 1;
+    hdr.dataOffset = O3_STORE_DATA_OFFSET;
+    hdr.latMin = grid.latMin;
+    hdr.lonMin = grid.lonMin;
+    hdr.step = grid.step;
+    hdr.nLat = grid.nLat;
+    hdr.nLon = grid.nLon;
+    hdr.day0 = day0;
+    hdr.nDays = nDays;
+    const uint64_t dataBytes =
+        sizeof(float) * static_cast<uint64_t>(grid.size()) * nDays;
+    hdr.flagsOffset = fillFlags ? hdr.dataOffset + dataBytes : 0;
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("Cannot create store: " + path);
+    // The flags start out zero (observed)
+    if (fillFlags &&
+        ::ftruncate(fd, static_cast<off_t>(hdr.flagsOffset + dataBytes / 4)) !=
+            0)
+      throw std::runtime_error("Cannot size store: " + path);
+
+    char page[O3_STORE_DATA_OFFSET] = {};
+    std::memcpy(page, &hdr, sizeof(hdr));
+    if (::pwrite(fd, page, sizeof(page), 0) != (ssize_t)sizeof(page))
+      throw std::runtime_error("Cannot write store header: " + path);
+
+    // Pre-fill every cell with the missing marker
+    std::vector<float> empty(nDays, O3_MISSING);
+    for (O3CellId c = 0; c < grid.size(); ++c)
+      writeCell(c, empty.data());
+  }
+
+  // series (and filled, in a store with fill flags) must hold nDays
+  // values starting at day0. Cells may be written from several threads.
+  void writeCell(O3CellId cell, const float *series,
+                 const uint8_t *filled = nullptr) {
+    const size_t bytes = sizeof(float) * hdr.nDays;
+    const off_t off = hdr.dataOffset + static_cast<off_t>(cell) * bytes;
+    if (::pwrite(fd, series, bytes, off) != (ssize_t)bytes)
+      throw std::runtime_error("Short write in store");
+    if (filled && hdr.flagsOffset) {
+      const off_t flagsOff =
+          hdr.flagsOffset + static_cast<off_t>(cell) * hdr.nDays;
+      if (::pwrite(fd, filled, hdr.nDays, flagsOff) != (ssize_t)hdr.nDays)
+        throw std::runtime_error("Short write in store");
+    }
+  }
+
+  ~O3StoreWriter() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  O3StoreWriter(const O3StoreWriter &) = delete;
+  O3StoreWriter &operator=(const O3StoreWriter &) = delete;
+};
+
+// Read-only view of a store file. Queries touch only the pages of the
+// (at most four) cells involved, so they cost microseconds once the
+// pages are cached.
+class O3Store {
+private:
+  int fd = -1;
+  size_t mapSize = 0;
+  const char *base = nullptr;
+  const O3StoreHeader *hdr = nullptr;
+  const float *data = nullptr;
+  const uint8_t *flags = nullptr;
+
+public:
+  explicit O3Store(const std::string &path) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("Cannot open store: " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)O3_STORE_DATA_OFFSET) {
+      ::close(fd);
+      throw std::runtime_error("Not a store file: " + path);
+    }
+    mapSize = static_cast<size_t>(st.st_size);
+
+    void *p = ::mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Cannot map store: " + path);
+    }
+    base = static_cast<const char *>(p);
+    hdr = reinterpret_cast<const O3StoreHeader *>(base);
+
+    const size_t values =
+        static_cast<size_t>(hdr->nLat) * hdr->nLon * hdr->nDays;
+    const size_t expected =
+        hdr->flagsOffset ? hdr->flagsOffset + values
+                         : hdr->dataOffset + sizeof(float) * values;
+    if (std::memcmp(hdr->magic, "O3STORE1", 8) != 0 || mapSize < expected) {
+      ::munmap(p, mapSize);
+      ::close(fd);
+      throw std::runtime_error("Corrupt store file: " + path);
+    }
+    data = reinterpret_cast<const float *>(base + hdr->dataOffset);
+    if (hdr->flagsOffset)
+      flags = reinterpret_cast<const uint8_t *>(base + hdr->flagsOffset);
+  }
+
+  ~O3Store() {
+    if (base)
+      ::munmap(const_cast<char *>(base), mapSize);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  O3Store(const O3Store &) = delete;
+  O3Store &operator=(const O3Store &) = delete;
+
+  const O3StoreHeader &header() const { return *hdr; }
+
+  O3Grid grid() const {
+    O3Grid g;
+    g.latMin = hdr->latMin;
+    g.lonMin = hdr->lonMin;
+    g.step = hdr->step;
+    g.nLat = hdr->nLat;
+    g.nLon = hdr->nLon;
+    return g;
+  }
+
+  int32_t firstDay() const { return hdr->day0; }
+  int32_t lastDay() const { return hdr->day0 + hdr->nDays - 1; }
+
+  // True if (lat, lon) lies on the grid or within half a step of its edge
+  // cells; queries elsewhere return no values
+  bool covers(double lat, double lon) const {
+    const double fy = (lat - hdr->latMin) / hdr->step;
+    const double fx = (lon - hdr->lonMin) / hdr->step;
+    return fy >= -0.5 && fy <= hdr->nLat - 0.5 && fx >= -0.5 &&
+           fx <= hdr->nLon - 0.5;
+  }
+
+  // Whole series of one grid cell
+  const float *cell(O3CellId id) const {
+    return data + static_cast<size_t>(id) * hdr->nDays;
+  }
+  const float *cell(int iLat, int iLon) const {
+    return cell(iLat * hdr->nLon + iLon);
+  }
+
+  // Fill flags of one grid cell (see the layout above); nullptr unless the
+  // store was gap filled
+  const uint8_t *filled(O3CellId id) const {
+    return flags ? flags + static_cast<size_t>(id) * hdr->nDays : nullptr;
+  }
+  const uint8_t *filled(int iLat, int iLon) const {
+    return filled(iLat * hdr->nLon + iLon);
+  }
+
+  // Writes the series for [t0, t1] (days since epoch, inclusive, clamped to
+  // the store range) into out and returns the number of values written, 0
+  // for a point the store does not cover.
+  // With observedOnly, the filled days of a gap-filled store read as the
+  // markers they replaced.
+  size_t seriesInto(double lat, double lon, int32_t t0, int32_t t1, float *out,
+                    O3Interp mode = O3Interp::Nearest,
+                    bool observedOnly = false) const {
+    t0 = std::max(t0, firstDay());
+    t1 = std::min(t1, lastDay());
+    if (t1 < t0 || !covers(lat, lon))
+      return 0;
+    const size_t n = static_cast<size_t>(t1 - t0 + 1);
+    const size_t off = static_cast<size_t>(t0 - hdr->day0);
+
+    const double fy = (lat - hdr->latMin) / hdr->step;
+    const double fx = (lon - hdr->lonMin) / hdr->step;
+
+    auto clampIdx = [](long v, int nMax) {
+      return static_cast<int>(std::min<long>(std::max<long>(v, 0), nMax - 1));
+    };
+    const int nearLat = clampIdx(std::lround(fy), hdr->nLat);
+    const int nearLon = clampIdx(std::lround(fx), hdr->nLon);
+    const float *nearest = cell(nearLat, nearLon) + off;
+
+    // Flags of a corner when filled days are left out
+    auto flagsOf = [&](int iLat, int iLon) -> const uint8_t * {
+      const uint8_t *f = observedOnly ? filled(iLat, iLon) : nullptr;
+      return f ? f + off : nullptr;
+    };
+    auto valueOf = [](const float *c, const uint8_t *f, size_t i) {
+      return f && f[i] ? -static_cast<float>(f[i]) : c[i];
+    };
+    const uint8_t *nearestFlags = flagsOf(nearLat, nearLon);
+
+    if (mode == O3Interp::Nearest || hdr->nLat < 2 || hdr->nLon < 2) {
+      if (nearestFlags) {
+        for (size_t i = 0; i < n; ++i)
+          out[i] = valueOf(nearest, nearestFlags, i);
+      } else {
+        std::memcpy(out, nearest, n * sizeof(float));
+      }
+      return n;
+    }
+
+    const int y0 = clampIdx(static_cast<long>(std::floor(fy)), hdr->nLat - 1);
+    const int x0 = clampIdx(static_cast<long>(std::floor(fx)), hdr->nLon - 1);
+    const float wy = static_cast<float>(std::clamp(fy - y0, 0.0, 1.0));
+    const float wx = static_cast<float>(std::clamp(fx - x0, 0.0, 1.0));
+
+    const float *c00 = cell(y0, x0) + off;
+    const float *c01 = cell(y0, x0 + 1) + off;
+    const float *c10 = cell(y0 + 1, x0) + off;
+    const float *c11 = cell(y0 + 1, x0 + 1) + off;
+    const uint8_t *f00 = flagsOf(y0, x0), *f01 = flagsOf(y0, x0 + 1);
+    const uint8_t *f10 = flagsOf(y0 + 1, x0), *f11 = flagsOf(y0 + 1, x0 + 1);
+    const float w00 = (1 - wy) * (1 - wx), w01 = (1 - wy) * wx;
+    const float w10 = wy * (1 - wx), w11 = wy * wx;
+
+    // Fill-aware: corners holding a marker (<= 0) drop out and the
+    // remaining weights are renormalised. If no corner is valid the nearest
+    // cell's marker is kept so -1/-2/-3 keep their meaning.
+    for (size_t i = 0; i < n; ++i) {
+      const float v00 = valueOf(c00, f00, i), v01 = valueOf(c01, f01, i);
+      const float v10 = valueOf(c10, f10, i), v11 = valueOf(c11, f11, i);
+      float sum = 0, wsum = 0;
+      if (v00 > 0) {
+        sum += w00 * v00;
+        wsum += w00;
+      }
+      if (v01 > 0) {
+        sum += w01 * v01;
+        wsum += w01;
+      }
+      if (v10 > 0) {
+        sum += w10 * v10;
+        wsum += w10;
+      }
+      if (v11 > 0) {
+        sum += w11 * v11;
+        wsum += w11;
+      }
+      out[i] = (wsum > 0) ? sum / wsum : valueOf(nearest, nearestFlags, i);
+    }
+    return n;
+  }
+
+  std::vector<float> series(double lat, double lon, int32_t t0, int32_t t1,
+                            O3Interp mode = O3Interp::Nearest,
+                            bool observedOnly = false) const {
+    std::vector<float> out(
+        std::max<int32_t>(0, std::min(t1, lastDay()) -
+                                 std::max(t0, firstDay()) + 1));
+    out.resize(
+        seriesInto(lat, lon, t0, t1, out.data(), mode, observedOnly));
+    return out;
+  }
+};
+
+#endif
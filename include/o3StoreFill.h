@@ -0,0 +1,353 @@
+// o3StoreFill.h
+// Gap filling of a whole store (ozone_query fill). Every day holding a
+// marker (-1, -2, -3) gets its cell's climatology for that calendar day plus
+// an estimated anomaly, and is flagged in the output store with the marker
+// it replaced (see o3Store.h), so analyses can leave filled days out
+// (O3Store::series with observedOnly).
+//
+// Each cell's series is read once for its statistics:
+//   climatology  mean of every leap-calendar day (o3LeapSlot) over the
+//                years, smoothed over +-7 days
+//   anomalies    value - climatology on the observed days: their standard
+//                deviation and lag-1 autocorrelation phi
+// and the anomaly of a missing day is
+//   temporal     the AR(1) bridge between the nearest observed anomalies
+//                before and after it, phi^d from one side; it decays to 0
+//                (plain climatology) inside long gaps
+//   spatial      the mean standardized anomaly of the observed 8 neighbour
+//                cells that day, in this cell's units; temporal where no
+//                neighbour is observed
+//   none         0
+//
+// Cells are processed in parallel. The loops along time run over
+// contiguous arrays without branches, one run per stretch of consecutive
+// calendar slots, so the compiler vectorizes them.
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3STOREFILL_H
+#define O3STOREFILL_H
+
+#include "o3Date.h"
+#include "o3Store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class O3Anomaly { None, Temporal, Spatial };
+
+// "none", "temporal" or "spatial"
+inline bool o3ParseAnomaly(const std::string &text, O3Anomaly &mode) {
+  if (text == "none")
+    mode = O3Anomaly::None;
+  else if (text == "temporal")
+    mode = O3Anomaly::Temporal;
+  else if (text == "spatial")
+    mode = O3Anomaly::Spatial;
+  else
+    return false;
+  return true;
+}
+
+struct O3StoreFillOptions {
+  O3Anomaly anomaly = O3Anomaly::Temporal;
+  int maxGap = 0;       // longest run of missing days filled; 0: all
+  unsigned threads = 0; // 0: one per hardware thread
+};
+
+struct O3StoreFillResult {
+  size_t cells = 0, cellsWithData = 0;
+  uint64_t filledDays = 0;
+  uint64_t leftDays = 0; // in longer gaps, or cells without data
+  double meanPhi = 0;    // over the cells with data
+};
+
+class O3StoreFiller {
+private:
+  static constexpr int slots = 366;
+  static constexpr int window = 7;
+
+  // Consecutive days whose calendar slots are consecutive too
+  struct Run {
+    int32_t offset, slot, length;
+  };
+
+  // Per worker scratch series
+  struct Buffers {
+    std::vector<float> anom, est, zSum, zCount, out, power;
+    std::vector<int32_t> prev, next;
+    std::vector<uint8_t> flags;
+  };
+
+  const O3Store &store;
+  O3StoreFillOptions options;
+  O3Grid grid;
+  int32_t nDays;
+  std::vector<Run> runs;
+  std::vector<float> clim; // [cell][slot]
+  std::vector<float> phi, sd;
+  std::vector<uint8_t> hasData;
+
+  template <class Work> void forEachCell(Work work) {
+    unsigned n = options.threads ? options.threads
+                                 : std::thread::hardware_concurrency();
+    n = std::max(1u, std::min<unsigned>(n, grid.size()));
+    std::atomic<int> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < n; ++t) {
+      workers.emplace_back([&] {
+        Buffers buffers;
+        for (int c = next++; c < grid.size(); c = next++)
+          work(static_cast<O3CellId>(c), buffers);
+      });
+    }
+    for (std::thread &w : workers)
+      w.join();
+  }
+
+  // a = value - climatology on observed days, 0 elsewhere
+  void anomalies(const float *v, const float *cl, float *a) const {
+    for (const Run &r : runs) {
+      const float *x = v + r.offset, *c = cl + r.slot;
+      float *o = a + r.offset;
+      for (int32_t k = 0; k < r.length; ++k)
+        o[k] = x[k] > 0 ? x[k] - c[k] : 0.0f;
+    }
+  }
+
+  void statistics(O3CellId c, Buffers &b) {
+    const float *v = store.cell(c);
+    // A slot sums one value per year, well within float precision
+    float sum[slots] = {}, count[slots] = {};
+    for (const Run &r : runs) {
+      const float *x = v + r.offset;
+      float *s = sum + r.slot, *n = count + r.slot;
+      for (int32_t k = 0; k < r.length; ++k) {
+        s[k] += x[k] > 0 ? x[k] : 0.0f;
+        n[k] += x[k] > 0 ? 1.0f : 0.0f;
+      }
+    }
+    double total = 0, totalCount = 0;
+    for (int s = 0; s < slots; ++s) {
+      total += sum[s];
+      totalCount += count[s];
+    }
+    if (totalCount == 0)
+      return;
+
+    // Slots with no data within the window take the mean of the cell
+    float *cl = &clim[static_cast<size_t>(c) * slots];
+    for (int s = 0; s < slots; ++s) {
+      double ws = 0, wn = 0;
+      for (int j = -window; j <= window; ++j) {
+        const int k = (s + j + slots) % slots;
+        ws += sum[k];
+        wn += count[k];
+      }
+      cl[s] = static_cast<float>(wn > 0 ? ws / wn : total / totalCount);
+    }
+
+    b.anom.resize(nDays);
+    anomalies(v, cl, b.anom.data());
+    const float *a = b.anom.data();
+    double ssq = 0, lag = 0, pairs = 0;
+    for (int32_t i = 0; i < nDays; ++i)
+      ssq += static_cast<double>(a[i]) * a[i];
+    for (int32_t i = 0; i + 1 < nDays; ++i) {
+      lag += static_cast<double>(a[i]) * a[i + 1];
+      pairs += (v[i] > 0) & (v[i + 1] > 0);
+    }
+    const double var = ssq / totalCount;
+    hasData[c] = 1;
+    sd[c] = static_cast<float>(std::sqrt(var));
+    phi[c] = pairs > 0 && var > 0
+                 ? static_cast<float>(std::clamp(lag / pairs / var, 0.0, 0.99))
+                 : 0.0f;
+  }
+
+  // AR(1) estimate of the anomaly of every missing day; prev/next hold the
+  // nearest observed day before and after (-1 / nDays if none)
+  void temporal(const float *v, O3CellId c, Buffers &b) const {
+    const int32_t n = nDays;
+    int32_t last = -1;
+    for (int32_t i = 0; i < n; ++i) {
+      b.prev[i] = last;
+      last = v[i] > 0 ? i : last;
+    }
+    last = n;
+    for (int32_t i = n - 1; i >= 0; --i) {
+      b.next[i] = last;
+      last = v[i] > 0 ? i : last;
+    }
+
+    if (options.anomaly == O3Anomaly::None) {
+      std::fill(b.est.begin(), b.est.end(), 0.0f);
+      return;
+    }
+    // phi^k; a gap is at most n days long, the bridge needs 2 (da + db)
+    b.power.resize(2 * static_cast<size_t>(n) + 1);
+    double p = 1;
+    for (float &w : b.power) {
+      w = static_cast<float>(p);
+      p *= phi[c];
+    }
+    const float *pw = b.power.data(), *a = b.anom.data();
+    for (int32_t i = 0; i < n; ++i) {
+      const int32_t before = b.prev[i], after = b.next[i];
+      const int32_t da = i - before, db = after - i;
+      float e = 0;
+      if (before >= 0 && after < n) {
+        e = (pw[da] * (1 - pw[2 * db]) * a[before] +
+             pw[db] * (1 - pw[2 * da]) * a[after]) /
+            (1 - pw[2 * (da + db)]);
+      } else if (before >= 0) {
+        e = pw[da] * a[before];
+      } else if (after < n) {
+        e = pw[db] * a[after];
+      }
+      b.est[i] = e;
+    }
+  }
+
+  // Replaces the temporal estimate with the neighbours' standardized
+  // anomaly where any neighbour is observed
+  void spatial(O3CellId c, Buffers &b) const {
+    std::fill(b.zSum.begin(), b.zSum.end(), 0.0f);
+    std::fill(b.zCount.begin(), b.zCount.end(), 0.0f);
+    const int iLat = c / grid.nLon, iLon = c % grid.nLon;
+    const bool global = grid.nLon * grid.step >= 360 - 1e-6;
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        int y = iLat + dy, x = iLon + dx;
+        if (global)
+          x = (x + grid.nLon) % grid.nLon;
+        if ((dy == 0 && dx == 0) || y < 0 || y >= grid.nLat || x < 0 ||
+            x >= grid.nLon)
+          continue;
+        const O3CellId nb = y * grid.nLon + x;
+        if (nb == c || !hasData[nb] || sd[nb] <= 0)
+          continue;
+        const float *nv = store.cell(nb);
+        const float *ncl = &clim[static_cast<size_t>(nb) * slots];
+        const float inv = 1 / sd[nb];
+        for (const Run &r : runs) {
+          const float *x0 = nv + r.offset, *cl = ncl + r.slot;
+          float *zs = b.zSum.data() + r.offset;
+          float *zc = b.zCount.data() + r.offset;
+          for (int32_t k = 0; k < r.length; ++k) {
+            const bool ok = x0[k] > 0;
+            zs[k] += ok ? (x0[k] - cl[k]) * inv : 0.0f;
+            zc[k] += ok;
+          }
+        }
+      }
+    }
+    const float scale = sd[c];
+    const float *zs = b.zSum.data(), *zc = b.zCount.data();
+    float *e = b.est.data();
+    for (int32_t i = 0; i < nDays; ++i)
+      e[i] = zc[i] > 0 ? scale * zs[i] / std::max(zc[i], 1.0f) : e[i];
+  }
+
+  void fill(O3CellId c, Buffers &b, O3StoreWriter &writer,
+            std::atomic<uint64_t> &filled, std::atomic<uint64_t> &left) {
+    const float *v = store.cell(c);
+    b.flags.assign(nDays, 0);
+    if (!hasData[c]) {
+      writer.writeCell(c, v, b.flags.data());
+      left += std::count_if(v, v + nDays, [](float x) { return !(x > 0); });
+      return;
+    }
+
+    const float *cl = &clim[static_cast<size_t>(c) * slots];
+    b.anom.resize(nDays);
+    b.est.resize(nDays);
+    b.prev.resize(nDays);
+    b.next.resize(nDays);
+    b.out.resize(nDays);
+    anomalies(v, cl, b.anom.data());
+    temporal(v, c, b);
+    if (options.anomaly == O3Anomaly::Spatial) {
+      b.zSum.resize(nDays);
+      b.zCount.resize(nDays);
+      spatial(c, b);
+    }
+
+    const int32_t maxGap = options.maxGap > 0 ? options.maxGap : nDays;
+    uint64_t nFilled = 0, nLeft = 0;
+    for (const Run &r : runs) {
+      const float *x = v + r.offset, *clim0 = cl + r.slot;
+      const float *e = b.est.data() + r.offset;
+      const int32_t *before = b.prev.data() + r.offset;
+      const int32_t *after = b.next.data() + r.offset;
+      float *o = b.out.data() + r.offset;
+      uint8_t *f = b.flags.data() + r.offset;
+      const int32_t length = r.length; // f may alias r
+      int32_t runFilled = 0, runMissing = 0;
+      for (int32_t k = 0; k < length; ++k) {
+        const float estimate = clim0[k] + e[k];
+        const bool missing = !(x[k] > 0);
+        const bool use = missing & (after[k] - before[k] - 1 <= maxGap) &
+                         (estimate > 0);
+        // Markers are small negative integers; the flag keeps the one
+        // replaced
+        const float code = std::min(std::max(-x[k], 1.0f), 255.0f) + 0.5f;
+        o[k] = use ? estimate : x[k];
+        f[k] = use ? static_cast<uint8_t>(static_cast<int32_t>(code)) : 0;
+        runFilled += use;
+        runMissing += missing;
+      }
+      nFilled += runFilled;
+      nLeft += runMissing - runFilled;
+    }
+    writer.writeCell(c, b.out.data(), b.flags.data());
+    filled += nFilled;
+    left += nLeft;
+  }
+
+public:
+  O3StoreFiller(const O3Store &in, const O3StoreFillOptions &opt)
+      : store(in), options(opt), grid(in.grid()), nDays(in.header().nDays) {
+    for (int32_t i = 0; i < nDays; ++i) {
+      const int slot = o3LeapSlot(in.firstDay() + i);
+      if (runs.empty() ||
+          slot != runs.back().slot + runs.back().length)
+        runs.push_back({i, slot, 1});
+      else
+        ++runs.back().length;
+    }
+    clim.assign(static_cast<size_t>(grid.size()) * slots, 0.0f);
+    phi.assign(grid.size(), 0.0f);
+    sd.assign(grid.size(), 0.0f);
+    hasData.assign(grid.size(), 0);
+  }
+
+  // Writes the filled store to outPath; throws if it cannot be written
+  O3StoreFillResult run(const std::string &outPath) {
+    forEachCell([&](O3CellId c, Buffers &b) { statistics(c, b); });
+
+    O3StoreWriter writer(outPath, grid, store.firstDay(), nDays, true);
+    std::atomic<uint64_t> filled{0}, left{0};
+    forEachCell(
+        [&](O3CellId c, Buffers &b) { fill(c, b, writer, filled, left); });
+
+    O3StoreFillResult result;
+    result.cells = grid.size();
+    for (int c = 0; c < grid.size(); ++c) {
+      result.cellsWithData += hasData[c];
+      result.meanPhi += hasData[c] ? phi[c] : 0;
+    }
+    if (result.cellsWithData)
+      result.meanPhi /= result.cellsWithData;
+    result.filledDays = filled;
+    result.leftDays = left;
+    return result;
+  }
+};
+
+#endif
@@ -0,0 +1,198 @@
+// o3TextIO.h
+// Fast reading and writing of the whitespace separated numeric text files
+// (day month year value .dat files, sunspot files, sorted chi2 tables).
+//
+// O3TextReader loads a whole file (or an archive member) in one read and
+// parses it in place with std::from_chars; O3TextWriter formats with
+// std::to_chars into a buffer that is written in large blocks, with no
+// per-line flush. Neither depends on the locale.
+//
+// Numbers are written as ostream << does by default (%g, 6 significant
+// digits), so files keep their exact text:
+//
+//   O3TextWriter out(fileName);
+//   out << d << '\t' << m << '\t' << y << '\t' << value << '\n';
+//
+//   O3TextReader in;
+//   if (in.open(fileName))
+//     while (in.row(d, m, y, value))
+//       ...
+//
+// Header only, no ROOT dependencies.
+
+#ifndef O3TEXTIO_H
+#define O3TEXTIO_H
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+class O3TextReader {
+private:
+  std::string buffer;
+  const char *pos = nullptr, *end = nullptr;
+
+  void skipSpace() {
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' ||
+                         *pos == '\r' || *pos == '\f' || *pos == '\v'))
+      ++pos;
+  }
+
+  template <class T> bool field(T &value) {
+    skipSpace();
+    const char *first = pos;
+    if (first < end && *first == '+')
+      ++first;
+    const auto [last, ec] = std::from_chars(first, end, value);
+    if (ec != std::errc())
+      return false;
+    pos = last;
+    return true;
+  }
+
+public:
+  // Reads the whole file; false if it cannot be read
+  bool open(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+      return false;
+    std::string data;
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    const long size = ok ? std::ftell(file) : -1;
+    ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+      data.resize(static_cast<size_t>(size));
+      ok = std::fread(data.data(), 1, data.size(), file) == data.size();
+    }
+    std::fclose(file);
+    if (ok)
+      assign(std::move(data));
+    return ok;
+  }
+
+  // Parses text already in memory (e.g. an o3ReadArtifact result)
+  void assign(std::string text) {
+    buffer = std::move(text);
+    pos = buffer.data();
+    end = pos + buffer.size();
+  }
+
+  // Reads the next fields in order; false at the end of the data or on a
+  // field that is not a number
+  template <class... T> bool row(T &...fields) {
+    return (field(fields) && ...);
+  }
+
+  bool atEnd() {
+    skipSpace();
+    return pos == end;
+  }
+
+  // Releases the buffer
+  void close() { assign(std::string()); }
+};
+
+class O3TextWriter {
+private:
+  static constexpr size_t blockSize = 1 << 20;
+
+  std::string buffer;
+  std::FILE *file = nullptr;
+  bool ok = true;
+
+  void spill() {
+    if (file && buffer.size() >= blockSize) {
+      ok = std::fwrite(buffer.data(), 1, buffer.size(), file) ==
+               buffer.size() &&
+           ok;
+      buffer.clear();
+    }
+  }
+
+  template <class T> O3TextWriter &number(T value) {
+    char text[32];
+    const auto [last, ec] = std::to_chars(text, text + sizeof(text), value);
+    buffer.append(text, ec == std::errc() ? last - text : 0);
+    spill();
+    return *this;
+  }
+
+public:
+  // In memory: the text is taken with str()
+  O3TextWriter() = default;
+
+  // Writes to path (truncated) in blocks; check isOpen()
+  explicit O3TextWriter(const std::string &path) { open(path); }
+
+  O3TextWriter(const O3TextWriter &) = delete;
+  O3TextWriter &operator=(const O3TextWriter &) = delete;
+
+  ~O3TextWriter() { close(); }
+
+  // Closes any open file and starts writing to path; false if it cannot
+  // be created
+  bool open(const std::string &path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    ok = file != nullptr;
+    buffer.reserve(blockSize + 256);
+    return ok;
+  }
+
+  bool isOpen() const { return file != nullptr; }
+
+  O3TextWriter &operator<<(int value) { return number(value); }
+  O3TextWriter &operator<<(long value) { return number(value); }
+
+  // %g with 6 significant digits, as ostream << value
+  O3TextWriter &operator<<(double value) {
+    char text[32];
+    const auto [last, ec] = std::to_chars(text, text + sizeof(text), value,
+                                          std::chars_format::general, 6);
+    buffer.append(text, ec == std::errc() ? last - text : 0);
+    spill();
+    return *this;
+  }
+
+  O3TextWriter &operator<<(char c) {
+    buffer.push_back(c);
+    return *this;
+  }
+
+  O3TextWriter &operator<<(std::string_view text) {
+    buffer.append(text);
+    spill();
+    return *this;
+  }
+
+  // value zero padded to width digits ("%02d")
+  O3TextWriter &padded(int value, int width) {
+    char text[16];
+    const auto [last, ec] = std::to_chars(text, text + sizeof(text), value);
+    const int n = ec == std::errc() ? static_cast<int>(last - text) : 0;
+    if (value >= 0 && n < width)
+      buffer.append(width - n, '0');
+    buffer.append(text, n);
+    return *this;
+  }
+
+  // The text of an in-memory writer
+  const std::string &str() const { return buffer; }
+
+  // Writes what is left and closes the file; false if any write failed
+  bool close() {
+    if (file) {
+      ok = std::fwrite(buffer.data(), 1, buffer.size(), file) ==
+               buffer.size() &&
+           ok;
+      ok = std::fclose(file) == 0 && ok;
+      file = nullptr;
+      buffer.clear();
+    }
+    return ok;
+  }
+};
+
+#endif
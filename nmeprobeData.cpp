@@ -1,22 +1,18 @@
-#include <cmath>
-#include <cstdio>
-#include <cstring>
-#include <filesystem>
-#include <fstream>
+// TOMS stage of the pipeline as a standalone tool
+#include "include/o3Cancel.h"
+#include "include/o3ExtractCache.h"
+#include "include/o3Pipeline.h"
+
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <unistd.h> // for getpid()
 
-namespace fs = std::filesystem;
 using namespace std;
 
-constexpr float XMin = -179.375f;
-constexpr float step = 1.25f;
-constexpr int bpLine = 25; // bins per line
-
 void usage() {
   cout << "-A<latitude> -B<longitude> -P<prefix i.e BOG> -D</path/to/data> "
-          "-S<opt>"
+          "-S<opt> [-O<output dir>] [-C<cache dir>]"
        << endl;
   cout << "In this case, please use opt = 1 for nimbus" << endl;
   cout << "                         opt = 2 for meteor" << endl;
@@ -28,13 +24,17 @@ float lat{};
 float lon{};
 string prefix{};
 string pathtodata{};
+string outputdir{"."};
+string cachedir{};
 int opt{};
 
 int main(int argc, char *argv[]) {
 
-  if (argc != 6) {
+  if (argc < 6 || argc > 8) {
     usage();
   }
+  // SIGINT/SIGTERM stop the extraction between files; nothing is written
+  o3InstallCancelHandlers();
 
   while ((argc > 1) && (argv[1][0] == '-')) {
     switch (argv[1][1]) {
@@ -66,6 +66,16 @@ int main(int argc, char *argv[]) {
       opt = strtol(&argv[1][2], nullptr, 10);
       break;
 
+      // existing directory for the yearly .dat files
+    case 'O':
+      outputdir = string(&argv[1][2]);
+      break;
+
+      // extraction cache shared with optimized_ozone_processor
+    case 'C':
+      cachedir = string(&argv[1][2]);
+      break;
+
     default:
       cerr << "Please check options ... " << '\n' << '\n';
       usage();
@@ -77,200 +87,39 @@ int main(int argc, char *argv[]) {
 
   cout << "Lat: " << lat << " Lon: " << lon << "location: " << prefix << endl;
 
-  // Get process ID to make temporary files unique
-  pid_t process_id = getpid();
-
-  // Check if directory exists using std::filesystem
-  if (!fs::exists(pathtodata) || !fs::is_directory(pathtodata)) {
-    cerr << "path to data does not exist. Please check.." << endl;
-    exit(8);
+  if (opt < 1 || opt > 3) {
+    cerr << "Check options opt ?? .. " << endl;
+    exit(9);
   }
 
-  cout << "Path to data exists!! " << endl;
-  cout << pathtodata << endl;
-
-  cout << " location : " << prefix << endl;
-
-  const float latHalf = (lat >= 0) ? ceil(lat) - 0.5f : ceil(lat) + 0.5f;
-
-  if (abs(latHalf) > 89.5) {
-    cerr << "latitude not valid.." << endl;
-    cerr << "Please check." << endl;
+  // Bands and bins are located by o3ExtractTOMS (o3Pipeline.cpp) reading the
+  // L3 text files directly
+  O3LocationSeries series;
+  auto extract = [&](O3LocationSeries &s) {
+    return o3ExtractTOMS(pathtodata, lat, lon,
+                         static_cast<O3TomsSatellite>(opt), s);
+  };
+  bool ok;
+  if (cachedir.empty()) {
+    ok = extract(series);
+  } else {
+    const O3Source source = static_cast<O3Source>(opt);
+    try {
+      O3ExtractCache cache(cachedir, pathtodata);
+      ok = cache.get(source, o3SourceBin(source, lat, lon), extract, series);
+    } catch (const exception &e) {
+      cerr << e.what() << endl;
+      ok = false;
+    }
+  }
+  if (!ok) {
     exit(8);
   }
 
-  const float lonBin = (lon - XMin) / step + 1;
-  const int rLonBin = static_cast<int>(round(lonBin));
-
-  // in order to check if rLonBin - (rLonBin/bpLine)*25 is equal to cero
-  // or bigger. If cero, it must take line before it is calculated to
-  // obtain the string data and take the las 3 characteres of it.
-  // Otherwise everithing is ok
-  const int chkLonLine = rLonBin - (rLonBin / bpLine) * 25;
-
-  // reference line between 1 and 25
-  // find the line number from 1 to 12 (25 bins times 12 = 300)
-  // last bin has 13 bins plus " lat =  ### " reference
-  const int rnLine = rLonBin / bpLine + 1;
-  int nLine; // line to read from file
-
-  size_t found;
-
-  string strFName;
-  string str3e;
-  string strYY;
-  string strMM;
-  string strDD;
-
-  string sFileName;
-  string fileName;
-
-  ifstream inList;
-  ifstream inFile;
-  ifstream inLog;
-  ifstream inLogLatLine;
-  ofstream outFile;
-
-  int latLine;
-  int YMIN, YMAX;
-
-  float ud;
-
-  // Unique temporary file names using process ID
-  const string listFile = "list_" + to_string(process_id) + ".txt";
-  const string logLatLineFile = "logLatLine_" + to_string(process_id) + ".txt";
-  const string logLonLineFile = "logLonLine_" + to_string(process_id) + ".txt";
-
-  string sat;
-  if (opt == 1) {
-    YMIN = 1979;
-    YMAX = 1993;
-    sat = "nimbus_";
-  } else if (opt == 2) {
-    YMIN = 1994;
-    YMAX = 1994;
-    sat = "meteor_";
-  } else if (opt == 3) {
-    YMIN = 1996;
-    YMAX = 2004;
-    sat = "earth_";
-  } else {
-    cerr << "Check options opt ?? .. " << endl;
-    exit(9);
+  for (const auto &[year, rows] : series) {
+    cout << "PROCESSING YEAR:  " << year << " ... " << rows.size() << " files"
+         << endl;
   }
 
-  cout << " sat: " << sat << endl;
-
-  for (int i = YMIN; i <= YMAX; i++) {
-    const string outData = prefix + "_" + to_string(i) + ".dat";
-    outFile.open(outData);
-
-    const string dirFileName = pathtodata + sat + to_string(i);
-
-    cout << "dir: " << dirFileName << endl;
-
-    const string cmdName = "ls -1 " + dirFileName + "/L3*.txt > " + listFile;
-
-    system(cmdName.c_str());
-
-    cout << "PROCESSING YEAR:  " << i << " ..." << endl;
-
-    inList.open(listFile);
-    int dd = 0;
-    while (!inList.eof()) {
-      dd++;
-      inList >> fileName;
-      cout << "fileName: " << fileName << endl;
-
-      inFile.open(fileName);
-
-      // Build latitude string with proper formatting
-      string cLatHalf;
-      char buffer[20];
-      snprintf(buffer, sizeof(buffer), "%0.1f", latHalf);
-      cLatHalf = buffer;
-
-      string cmdSed = "sed -n '/lat =  ";
-      if (latHalf < -10) {
-        cmdSed += cLatHalf;
-      } else if ((latHalf > -10) && (latHalf < 0)) {
-        cmdSed += " " + cLatHalf;
-      } else if ((latHalf > 0) && (latHalf < 10)) {
-        cmdSed += "  " + cLatHalf;
-      } else {
-        cmdSed += " " + cLatHalf;
-      }
-
-      cmdSed += "/=' " + fileName + " > " + logLatLineFile;
-      system(cmdSed.c_str());
-
-      // latLine = 0;
-      inLogLatLine.open(logLatLineFile);
-      inLogLatLine >> latLine;
-      inLogLatLine.close();
-      fs::remove(logLatLineFile);
-
-      nLine = latLine - 12 + rnLine;
-
-      if (chkLonLine == 0)
-        nLine = nLine - 1;
-
-      const string cmdAwk = "awk 'FNR==" + to_string(nLine) + "' " + fileName +
-                            " > " + logLonLineFile;
-
-      system(cmdAwk.c_str());
-
-      string sLine;
-      string strBin;
-
-      ifstream inLogLonLine;
-      inLogLonLine.open(logLonLineFile);
-      getline(inLogLonLine, sLine);
-      inLogLonLine.close();
-      fs::remove(logLonLineFile);
-
-      if (chkLonLine == 0) {
-        strBin = sLine.substr(73, 3);
-      } else {
-        // there are 25*3 characters. sLine has 76 = 75 * a space from
-        // getline. We must add one position from getline and substract
-        // 3 positions because it will read the next value fro latitude
-        strBin =
-            sLine.substr((rLonBin - (rLonBin / bpLine) * 25) * 3 - 3 + 1, 3);
-      }
-      cout << "ud: " << strBin << endl;
-
-      ud = strtof(strBin.c_str(), nullptr);
-
-      sFileName = fileName;
-
-      if (opt == 1) {
-        str3e = "n7t";
-        found = sFileName.find(str3e);
-      } else if (opt == 2) {
-        str3e = "m3t";
-        found = sFileName.find(str3e);
-      } else {
-        str3e = "epc";
-        found = sFileName.find(str3e);
-      }
-
-      strYY = sFileName.substr(found + 4, 4);
-      strMM = sFileName.substr(found + 4 + 4, 2);
-      strDD = sFileName.substr(found + 4 + 4 + 2, 2);
-
-      if (ud <= 0)
-        ud = -1;
-
-      outFile << strDD << "\t" << strMM << "\t" << strYY << "\t" << ud << endl;
-      // cout << strDD << "\t" << strMM << "\t" << strYY << "\t" << ud << endl;
-
-    } // while
-    inList.close();
-    fs::remove(listFile);
-    outFile.close();
-
-  } // for
-
-  return 0;
+  return o3WriteYearFiles(outputdir, prefix, series) ? 0 : 1;
 }
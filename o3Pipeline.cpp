@@ -0,0 +1,661 @@
+// o3Pipeline.cpp
+// Stage implementations declared in include/o3Pipeline.h.
+//
+// Build with the tool that uses it, e.g.
+//   h5c++ -O3 -std=c++17 optimized_ozone_processor.cpp o3Pipeline.cpp
+//         -o optimized_ozone_processor
+#include "include/o3Pipeline.h"
+#include "include/o3Archive.h"
+#include "include/o3Cancel.h"
+#include "include/o3Store.h"
+#include "include/o3TextIO.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <hdf5.h>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// OMI/Aura L3 0.25 x 0.25 degree grid
+constexpr float OMI_STEP = 0.25f;
+constexpr float OMI_LAT0 = -89.875f;
+constexpr float OMI_LON0 = -179.875f;
+constexpr int OMI_YMIN = 2005;
+constexpr int OMI_YMAX = 2024;
+const char *OMI_DATASET =
+    "/HDFEOS/GRIDS/OMI Column Amount O3/Data Fields/ColumnAmountO3";
+
+// TOMS L3 1.25 degree longitude bins, 25 values per text line
+constexpr float TOMS_LON0 = -179.375f;
+constexpr float TOMS_STEP = 1.25f;
+constexpr int TOMS_BINS_PER_LINE = 25;
+
+// Year range, folder prefix and file name tag of each TOMS satellite
+struct TomsLayout {
+  int yMin, yMax;
+  const char *dirPrefix, *tag;
+};
+
+bool tomsLayout(O3TomsSatellite satellite, TomsLayout &layout) {
+  switch (satellite) {
+  case O3TomsSatellite::Nimbus7:
+    layout = {1979, 1993, "nimbus_", "n7t"};
+    return true;
+  case O3TomsSatellite::Meteor3:
+    layout = {1994, 1994, "meteor_", "m3t"};
+    return true;
+  case O3TomsSatellite::EarthProbe:
+    layout = {1996, 2004, "earth_", "epc"};
+    return true;
+  }
+  return false;
+}
+
+std::string withSlash(const std::string &path) {
+  return (!path.empty() && path.back() != '/') ? path + '/' : path;
+}
+
+// Regular files of dir starting with prefix and ending with suffix, sorted
+std::vector<std::string> listFiles(const std::string &dir,
+                                   const std::string &prefix,
+                                   const std::string &suffix) {
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    if (!entry.is_regular_file())
+      continue;
+    const std::string name = entry.path().filename().string();
+    if (name.rfind(prefix, 0) == 0 && name.size() >= suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+      files.push_back(entry.path().string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Writes contents to a temporary name next to fileName and renames it into
+// place, so a reader sees either the previous file or the complete new one
+bool writeFileAtomic(const std::string &fileName, const std::string &contents) {
+  const std::string tmpName = fileName + ".tmp" + std::to_string(::getpid());
+  {
+    std::ofstream out(tmpName, std::ios::binary);
+    if (!out.is_open()) {
+      std::cerr << "Cannot create output file: " << fileName << std::endl;
+      return false;
+    }
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out) {
+      std::cerr << "Failed writing: " << fileName << std::endl;
+      out.close();
+      std::remove(tmpName.c_str());
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmpName, fileName, ec);
+  if (ec) {
+    std::cerr << "Cannot rename " << tmpName << ": " << ec.message()
+              << std::endl;
+    std::remove(tmpName.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Longitude in [-180, 180): 180 is the -180 meridian
+float wrapLon(float lon) {
+  while (lon >= 180.0f)
+    lon -= 360.0f;
+  while (lon < -180.0f)
+    lon += 360.0f;
+  return lon;
+}
+
+void omiBin(float lat, float lon, int &binLat, int &binLon) {
+  binLat = std::max(
+      0, static_cast<int>(std::round((lat - OMI_LAT0) / OMI_STEP)));
+  binLon = std::max(
+      0, static_cast<int>(std::round((wrapLon(lon) - OMI_LON0) / OMI_STEP)));
+}
+
+// Band centre of the TOMS latitude label and 1-based longitude bin; false if
+// the latitude has no band
+bool tomsBin(float lat, float lon, float &latHalf, int &rLonBin) {
+  latHalf = (lat >= 0) ? std::ceil(lat) - 0.5f : std::ceil(lat) + 0.5f;
+  rLonBin = static_cast<int>(
+      std::round((wrapLon(lon) - TOMS_LON0) / TOMS_STEP + 1));
+  return std::fabs(latHalf) <= 89.5f;
+}
+
+// Non-threadsafe HDF5 builds need every call serialized
+std::mutex hdf5Mutex;
+
+float readOMIValue(const std::string &fileName, int binLat, int binLon) {
+  hbool_t threadsafe = 0;
+  H5is_library_threadsafe(&threadsafe);
+  std::unique_lock<std::mutex> lock(hdf5Mutex, std::defer_lock);
+  if (!threadsafe)
+    lock.lock();
+
+  H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);
+  float value = O3_INVALID;
+  hid_t file = H5Fopen(fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0)
+    return value;
+  hid_t dset = H5Dopen2(file, OMI_DATASET, H5P_DEFAULT);
+  if (dset >= 0) {
+    hid_t space = H5Dget_space(dset);
+    hsize_t start[2] = {static_cast<hsize_t>(binLat),
+                        static_cast<hsize_t>(binLon)};
+    hsize_t count[2] = {1, 1};
+    hsize_t one = 1;
+    hid_t mem = H5Screate_simple(1, &one, nullptr);
+    if (H5Sselect_hyperslab(space, H5S_SELECT_SET, start, nullptr, count,
+                            nullptr) >= 0 &&
+        H5Dread(dset, H5T_NATIVE_FLOAT, mem, space, H5P_DEFAULT, &value) < 0)
+      value = O3_INVALID;
+    H5Sclose(mem);
+    H5Sclose(space);
+    H5Dclose(dset);
+  }
+  H5Fclose(file);
+  return (value <= 0) ? O3_INVALID : value;
+}
+
+// OMI-Aura_L3-OMTO3e_2005m0101_v003-....he5
+bool omiDate(const std::string &fileName, O3DailyValue &v) {
+  const size_t pos = fileName.find("3e");
+  if (pos == std::string::npos || pos + 3 + 9 > fileName.size())
+    return false;
+  const std::string_view date = std::string_view(fileName).substr(pos + 3);
+  return o3ParseCivil(date.substr(0, 4), date.substr(5, 2), date.substr(7, 2),
+                      v.day);
+}
+
+// L3_ozone_n7t_19790101.txt
+bool tomsDate(const std::string &fileName, const char *tag, O3DailyValue &v) {
+  const size_t pos = fileName.find(tag);
+  if (pos == std::string::npos || pos + 4 + 8 > fileName.size())
+    return false;
+  const std::string_view date = std::string_view(fileName).substr(pos + 4);
+  return o3ParseCivil(date.substr(0, 4), date.substr(4, 2), date.substr(6, 2),
+                      v.day);
+}
+
+// Value of the 3 character column of a TOMS L3 file. Each latitude band is
+// 11 lines of 25 bins and a 12th line of 13 bins ending in
+// "lat =  <lat>"; the band is found by its label and the bin line counted
+// back from it.
+float readTOMSValue(const std::string &fileName, const std::string &latLabel,
+                    int rLonBin) {
+  std::ifstream in(fileName);
+  if (!in.is_open())
+    return O3_INVALID;
+
+  const int chkLonLine = rLonBin - (rLonBin / TOMS_BINS_PER_LINE) * 25;
+  const int rnLine = rLonBin / TOMS_BINS_PER_LINE + 1;
+
+  std::vector<std::string> lines;
+  std::string line;
+  int latLine = 0;
+  while (std::getline(in, line)) {
+    lines.push_back(line);
+    if (line.find(latLabel) != std::string::npos) {
+      latLine = static_cast<int>(lines.size());
+      break;
+    }
+  }
+  if (latLine == 0)
+    return O3_INVALID;
+
+  int nLine = latLine - 12 + rnLine;
+  if (chkLonLine == 0)
+    nLine -= 1;
+  if (nLine < 1 || nLine > static_cast<int>(lines.size()))
+    return O3_INVALID;
+
+  const std::string &sLine = lines[nLine - 1];
+  // Lines start with a blank, then 3 characters per bin
+  const size_t pos = (chkLonLine == 0) ? 73 : chkLonLine * 3 - 3 + 1;
+  if (pos + 3 > sLine.size())
+    return O3_INVALID;
+
+  const float ud = std::strtof(sLine.substr(pos, 3).c_str(), nullptr);
+  return (ud <= 0) ? O3_INVALID : ud;
+}
+
+} // namespace
+
+uint64_t o3SourceBin(O3Source source, float lat, float lon) {
+  int binLat, binLon;
+  if (source == O3Source::OMI) {
+    omiBin(lat, lon, binLat, binLon);
+  } else {
+    float latHalf;
+    tomsBin(lat, lon, latHalf, binLon);
+    binLat = static_cast<int>(std::lround(2 * latHalf)) + 1000;
+  }
+  return (static_cast<uint64_t>(source) << 48) |
+         (static_cast<uint64_t>(static_cast<uint32_t>(binLat)) << 24) |
+         static_cast<uint32_t>(binLon & 0xFFFFFF);
+}
+
+bool o3ExtractOMI(const std::string &dataPath, float lat, float lon,
+                  O3LocationSeries &series) {
+  const std::string base = withSlash(dataPath);
+  if (!fs::is_directory(base)) {
+    std::cerr << "Data path does not exist: " << base << std::endl;
+    return false;
+  }
+
+  int binLat, binLon;
+  omiBin(lat, lon, binLat, binLon);
+
+  for (int year = OMI_YMIN; year <= OMI_YMAX; ++year) {
+    std::vector<O3DailyValue> &rows = series[year];
+    rows.clear();
+
+    const std::vector<std::string> files =
+        listFiles(base + "aura_" + std::to_string(year), "", ".he5");
+    rows.reserve(files.size());
+    for (const std::string &file : files) {
+      if (o3Cancelled()) {
+        std::cerr << "OMI extraction cancelled" << std::endl;
+        return false;
+      }
+      O3DailyValue v;
+      if (!omiDate(fs::path(file).filename().string(), v)) {
+        std::cerr << "Could not extract date from: " << file << std::endl;
+        continue;
+      }
+      v.value = readOMIValue(file, binLat, binLon);
+      rows.push_back(v);
+    }
+  }
+  return true;
+}
+
+bool o3ExtractTOMS(const std::string &dataPath, float lat, float lon,
+                   O3TomsSatellite satellite, O3LocationSeries &series) {
+  const std::string base = withSlash(dataPath);
+  if (!fs::is_directory(base)) {
+    std::cerr << "Data path does not exist: " << base << std::endl;
+    return false;
+  }
+
+  float latHalf;
+  int rLonBin;
+  if (!tomsBin(lat, lon, latHalf, rLonBin)) {
+    std::cerr << "Latitude not valid: " << lat << std::endl;
+    return false;
+  }
+
+  // Band label as printed in the files ("lat =  -45.5", "lat =    5.5")
+  char latLabel[32];
+  std::snprintf(latLabel, sizeof(latLabel), "lat = %6.1f", latHalf);
+
+  TomsLayout layout;
+  if (!tomsLayout(satellite, layout)) {
+    std::cerr << "Unknown TOMS satellite" << std::endl;
+    return false;
+  }
+
+  for (int year = layout.yMin; year <= layout.yMax; ++year) {
+    std::vector<O3DailyValue> &rows = series[year];
+    rows.clear();
+
+    const std::vector<std::string> files = listFiles(
+        base + layout.dirPrefix + std::to_string(year), "L3", ".txt");
+    rows.reserve(files.size());
+    for (const std::string &file : files) {
+      if (o3Cancelled()) {
+        std::cerr << "TOMS extraction cancelled" << std::endl;
+        return false;
+      }
+      O3DailyValue v;
+      if (!tomsDate(fs::path(file).filename().string(), layout.tag, v)) {
+        std::cerr << "Could not extract date from: " << file << std::endl;
+        continue;
+      }
+      v.value = readTOMSValue(file, latLabel, rLonBin);
+      rows.push_back(v);
+    }
+  }
+  return true;
+}
+
+void o3ScanSources(const std::string &dataPath, O3SourceFiles files[4]) {
+  const std::string base = withSlash(dataPath);
+  auto scan = [&](O3SourceFiles &out, const std::string &dirPrefix, int yMin,
+                  int yMax, const char *prefix, const char *suffix) {
+    out = O3SourceFiles{};
+    std::string key;
+    for (int year = yMin; year <= yMax; ++year) {
+      const std::vector<std::string> names =
+          listFiles(base + dirPrefix + std::to_string(year), prefix, suffix);
+      if (!names.empty())
+        ++out.years;
+      for (const std::string &name : names) {
+        struct stat st;
+        const bool found = ::stat(name.c_str(), &st) == 0;
+        ++out.files;
+        out.bytes += found ? st.st_size : 0;
+        // Relative to the data path, so a moved copy keeps its fingerprint
+        key += name.substr(base.size()) + '\t' +
+               std::to_string(found ? st.st_size : -1) + '\t' +
+               std::to_string(found ? st.st_mtime : 0) + '\n';
+      }
+    }
+    out.fingerprint = o3Hash64(key);
+  };
+
+  scan(files[static_cast<int>(O3Source::OMI)], "aura_", OMI_YMIN, OMI_YMAX,
+       "", ".he5");
+  const O3TomsSatellite satellites[] = {O3TomsSatellite::Nimbus7,
+                                        O3TomsSatellite::Meteor3,
+                                        O3TomsSatellite::EarthProbe};
+  for (O3TomsSatellite sat : satellites) {
+    TomsLayout layout;
+    if (!tomsLayout(sat, layout))
+      continue;
+    scan(files[static_cast<int>(sat)], layout.dirPrefix, layout.yMin,
+         layout.yMax, "L3", ".txt");
+  }
+}
+
+void o3FillYear(int year, float marker, O3LocationSeries &series) {
+  O3SkimSeries gap;
+  o3FillGaps(gap, {o3YearRange(year)}, O3GapFill::Marker, marker);
+  series[year] = std::move(o3SkimYears(gap)[year]);
+}
+
+O3SkimSeries o3Skim(const O3LocationSeries &series) {
+  O3SkimSeries skim;
+  size_t nDays = 0;
+  for (const auto &[year, rows] : series) {
+    if (rows.empty())
+      continue;
+    skim.years.push_back(year);
+    nDays += o3DaysInYear(year);
+  }
+  skim.values.assign(nDays, O3_MISSING);
+
+  // Values go straight to their day; a repeated day keeps its last value
+  size_t offset = 0;
+  for (int year : skim.years) {
+    const int32_t jan1 = o3DaysFromCivil(year, 1, 1);
+    const int len = o3DaysInYear(year);
+    for (const O3DailyValue &v : series.at(year)) {
+      const int32_t i = v.day - jan1;
+      if (i >= 0 && i < len)
+        skim.values[offset + i] = v.value;
+    }
+    offset += len;
+  }
+  return skim;
+}
+
+O3LocationSeries o3SkimYears(const O3SkimSeries &skim) {
+  O3LocationSeries series;
+  size_t i = 0;
+  for (int year : skim.years) {
+    std::vector<O3DailyValue> &rows = series[year];
+    const int32_t jan1 = o3DaysFromCivil(year, 1, 1);
+    const int len = o3DaysInYear(year);
+    rows.reserve(len);
+    for (int k = 0; k < len; ++k)
+      rows.push_back({jan1 + k, skim.values[i++]});
+  }
+  return series;
+}
+
+std::vector<O3DayRange> o3CatalogGaps(const std::string &dataPath) {
+  const std::string base = withSlash(dataPath);
+  std::vector<int32_t> days;
+  O3DailyValue v;
+  for (int year = OMI_YMIN; year <= OMI_YMAX; ++year) {
+    for (const std::string &file :
+         listFiles(base + "aura_" + std::to_string(year), "", ".he5")) {
+      if (omiDate(fs::path(file).filename().string(), v))
+        days.push_back(v.day);
+    }
+  }
+  const O3TomsSatellite satellites[] = {O3TomsSatellite::Nimbus7,
+                                        O3TomsSatellite::Meteor3,
+                                        O3TomsSatellite::EarthProbe};
+  for (O3TomsSatellite sat : satellites) {
+    TomsLayout layout;
+    if (!tomsLayout(sat, layout))
+      continue;
+    for (int year = layout.yMin; year <= layout.yMax; ++year) {
+      for (const std::string &file :
+           listFiles(base + layout.dirPrefix + std::to_string(year), "L3",
+                     ".txt")) {
+        if (tomsDate(fs::path(file).filename().string(), layout.tag, v))
+          days.push_back(v.day);
+      }
+    }
+  }
+
+  std::sort(days.begin(), days.end());
+  days.erase(std::unique(days.begin(), days.end()), days.end());
+  std::vector<O3DayRange> gaps;
+  for (size_t i = 1; i < days.size(); ++i) {
+    if (days[i] > days[i - 1] + 1)
+      gaps.push_back({days[i - 1] + 1, days[i] - 1});
+  }
+  return gaps;
+}
+
+bool o3ParseGapFill(const std::string &text, O3GapFill &mode) {
+  if (text == "marker")
+    mode = O3GapFill::Marker;
+  else if (text == "linear")
+    mode = O3GapFill::Linear;
+  else if (text == "climatology")
+    mode = O3GapFill::Climatology;
+  else
+    return false;
+  return true;
+}
+
+size_t o3FillGaps(O3SkimSeries &skim, const std::vector<O3DayRange> &gaps,
+                  O3GapFill mode, float marker) {
+  // Years the gaps touch that the skim lacks are added as missing days
+  std::vector<int> years = skim.years;
+  for (const O3DayRange &g : gaps) {
+    for (int y = o3Civil(g.first).year; y <= o3Civil(g.last).year; ++y)
+      years.push_back(y);
+  }
+  std::sort(years.begin(), years.end());
+  years.erase(std::unique(years.begin(), years.end()), years.end());
+  if (years != skim.years) {
+    O3SkimSeries grown;
+    grown.years = years;
+    size_t nDays = 0;
+    for (int y : years)
+      nDays += o3DaysInYear(y);
+    grown.values.assign(nDays, O3_MISSING);
+    if (!skim.filled.empty())
+      grown.filled.assign(nDays, 0);
+    size_t from = 0, to = 0, k = 0;
+    for (int y : years) {
+      const size_t len = o3DaysInYear(y);
+      if (k < skim.years.size() && skim.years[k] == y) {
+        std::copy_n(skim.values.begin() + from, len,
+                    grown.values.begin() + to);
+        if (!skim.filled.empty())
+          std::copy_n(skim.filled.begin() + from, len,
+                      grown.filled.begin() + to);
+        from += len;
+        ++k;
+      }
+      to += len;
+    }
+    skim = std::move(grown);
+  }
+
+  // Day number and leap-calendar slot (0-365) of every position
+  const size_t n = skim.values.size();
+  std::vector<int32_t> dayOf(n);
+  std::vector<uint16_t> slotOf(n);
+  size_t i = 0;
+  for (int y : skim.years) {
+    const int32_t jan1 = o3DaysFromCivil(y, 1, 1);
+    const int len = o3DaysInYear(y);
+    for (int doy = 0; doy < len; ++doy, ++i) {
+      dayOf[i] = jan1 + doy;
+      slotOf[i] = static_cast<uint16_t>(o3LeapSlot(jan1 + doy));
+    }
+  }
+  std::vector<uint8_t> inGap(n, 0);
+  for (const O3DayRange &g : gaps) {
+    auto lo = std::lower_bound(dayOf.begin(), dayOf.end(), g.first);
+    auto hi = std::upper_bound(dayOf.begin(), dayOf.end(), g.last);
+    std::fill(inGap.begin() + (lo - dayOf.begin()),
+              inGap.begin() + (hi - dayOf.begin()), 1);
+  }
+  auto valid = [&](size_t j) { return !inGap[j] && skim.values[j] > 0; };
+
+  size_t estimated = 0;
+  auto set = [&](size_t j, float value) {
+    skim.values[j] = value;
+    skim.filled[j] = 1;
+    ++estimated;
+  };
+  if (mode == O3GapFill::Marker) {
+    for (size_t j = 0; j < n; ++j) {
+      if (inGap[j])
+        skim.values[j] = marker;
+    }
+    return 0;
+  }
+  if (skim.filled.empty())
+    skim.filled.assign(n, 0);
+
+  if (mode == O3GapFill::Climatology) {
+    std::vector<double> sum(366, 0.0);
+    std::vector<int> count(366, 0);
+    for (size_t j = 0; j < n; ++j) {
+      if (valid(j)) {
+        sum[slotOf[j]] += skim.values[j];
+        ++count[slotOf[j]];
+      }
+    }
+    for (size_t j = 0; j < n; ++j) {
+      if (!inGap[j])
+        continue;
+      const int c = count[slotOf[j]];
+      if (c > 0)
+        set(j, static_cast<float>(sum[slotOf[j]] / c));
+      else
+        skim.values[j] = marker;
+    }
+    return estimated;
+  }
+
+  // Linear: nearest valid position after each one (backward pass), then
+  // a forward pass that keeps the nearest valid position before it
+  std::vector<size_t> next(n);
+  size_t after = n;
+  for (size_t j = n; j-- > 0;) {
+    next[j] = after;
+    if (valid(j))
+      after = j;
+  }
+  size_t before = n;
+  for (size_t j = 0; j < n; ++j) {
+    if (!inGap[j]) {
+      if (valid(j))
+        before = j;
+      continue;
+    }
+    const size_t a = before, b = next[j];
+    if (a < n && b < n) {
+      const double t = static_cast<double>(dayOf[j] - dayOf[a]) /
+                       (dayOf[b] - dayOf[a]);
+      set(j, static_cast<float>(skim.values[a] +
+                                t * (skim.values[b] - skim.values[a])));
+    } else if (a < n || b < n) {
+      set(j, skim.values[a < n ? a : b]);
+    } else {
+      skim.values[j] = marker;
+    }
+  }
+  return estimated;
+}
+
+bool o3WriteYearFiles(const std::string &dir, const std::string &location,
+                      const O3LocationSeries &series) {
+  for (const auto &[year, rows] : series) {
+    const std::string fileName =
+        withSlash(dir) + location + "_" + std::to_string(year) + ".dat";
+    O3TextWriter out;
+    for (const O3DailyValue &v : rows) {
+      const O3Civil c = o3Civil(v.day);
+      out.padded(c.day, 2) << '\t';
+      out.padded(c.month, 2) << '\t' << c.year << '\t' << v.value << '\n';
+    }
+    if (!writeFileAtomic(fileName, out.str()))
+      return false;
+  }
+  return true;
+}
+
+bool o3ReadYearFiles(const std::string &dir, const std::string &location,
+                     O3LocationSeries &series) {
+  if (!fs::is_directory(dir)) {
+    std::cerr << "Cannot read directory: " << dir << std::endl;
+    return false;
+  }
+  for (const std::string &fileName : listFiles(dir, location + "_", ".dat")) {
+    O3TextReader in;
+    std::vector<O3DailyValue> rows;
+    int d, m, y;
+    float value;
+    if (in.open(fileName))
+      while (in.row(d, m, y, value))
+        rows.push_back({o3DaysFromCivil(y, m, d), value});
+    if (!rows.empty())
+      series[o3Civil(rows.front().day).year] = std::move(rows);
+  }
+  return true;
+}
+
+bool o3WriteSkim(const std::string &location, const O3SkimSeries &skim) {
+  const std::string outputDir = "skim_" + location;
+  std::error_code ec;
+  fs::create_directories(outputDir, ec);
+
+  const std::string fileName = outputDir + "/" + location + ".dat";
+  const std::string filledName = outputDir + "/" + location + "_filled.dat";
+  O3TextWriter out, filled;
+  size_t i = 0;
+  for (int year : skim.years)
+    for (int m = 1; m <= 12; ++m)
+      for (int d = 1; d <= o3DaysInMonth(year, m); ++d) {
+        out << d << '\t' << m << '\t' << year << '\t' << skim.values[i]
+            << '\n';
+        if (!skim.filled.empty() && skim.filled[i])
+          filled << d << '\t' << m << '\t' << year << '\n';
+        ++i;
+      }
+  // No estimated days: no list, and none left from an earlier run
+  if (filled.str().empty()) {
+    std::remove(filledName.c_str());
+  } else if (!writeFileAtomic(filledName, filled.str())) {
+    return false;
+  }
+  return writeFileAtomic(fileName, out.str());
+}
@@ -1,16 +1,18 @@
 // optimized_aprobe.cpp
+// OMI stage of the pipeline as a standalone tool; the extraction itself is
+// o3ExtractOMI (o3Pipeline.cpp, reads the HDF5 files through libhdf5).
+#include "include/o3Cancel.h"
+#include "include/o3ExtractCache.h"
+#include "include/o3Pipeline.h"
+
 #include <algorithm>
 #include <chrono>
 #include <cmath>
-#include <cstdio>
 #include <cstdlib>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <vector>
 
-namespace fs = std::filesystem;
 using namespace std;
 
 class OptimizedAprobe {
@@ -18,13 +20,13 @@ private:
   float lat, lon;
   string prefix;
   string pathToData;
+  string outputDir;
+  O3ExtractCache *cache;
 
   // coordinate conversion using compile-time constants
   static constexpr float STEP_A = 0.25f;
   static constexpr float XMIN_LAT_A = -89.875f;
   static constexpr float XMIN_LON_A = -179.875f;
-  static constexpr int YMIN = 2005;
-  static constexpr int YMAX = 2024;
 
   inline int calculateLatBin(float latitude) const noexcept {
     int bin = static_cast<int>(round((latitude - XMIN_LAT_A) / STEP_A));
@@ -36,91 +38,12 @@ private:
     return max(0, bin);
   }
 
-  // Check if directory exists without system calls
-  bool directoryExists(const string &path) const {
-    return fs::exists(path) && fs::is_directory(path);
-  }
-
-  // Get list of HE5 files
-  vector<string> getHE5Files(int year) const {
-    vector<string> files;
-    string dirPath = pathToData + "aura_" + to_string(year);
-
-    if (!directoryExists(dirPath)) {
-      cerr << "Directory does not exist: " << dirPath << endl;
-      return files;
-    }
-
-    try {
-      files.reserve(400); // Reserve space for typical year
-      for (const auto &entry : fs::directory_iterator(dirPath)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".he5") {
-          files.push_back(entry.path().string());
-        }
-      }
-    } catch (const fs::filesystem_error &e) {
-      cerr << "Error reading directory: " << e.what() << endl;
-    }
-
-    sort(files.begin(), files.end());
-    return files;
-  }
-
-  // Extract date from filename
-  struct DateInfo {
-    string day, month, year;
-    bool valid = false;
-  };
-
-  DateInfo extractDate(const string &filename) const {
-    DateInfo info;
-
-    size_t pos = filename.find("3e");
-    if (pos == string::npos)
-      return info;
-
-    pos += 3; // Skip "3e"
-    if (pos + 8 > filename.length())
-      return info;
-
-    info.year = filename.substr(pos, 4);
-    info.month = filename.substr(pos + 5, 2);
-    info.day = filename.substr(pos + 7, 2);
-    info.valid = true;
-
-    return info;
-  }
-
-  // Execute h5dump command
-  float executeH5Dump(const string &filename, int binLat, int binLon) const {
-    // Build h5dump command
-    string command = "h5dump -d \"/HDFEOS/GRIDS/OMI Column Amount O3/Data "
-                     "Fields/ColumnAmountO3[" +
-                     to_string(binLat) + "," + to_string(binLon) +
-                     ";,;,;,]\" -y \"" + filename +
-                     "\" 2>/dev/null | awk 'FNR == 11 {print $1}'";
-
-    // Execute command and capture output directly
-    FILE *pipe = popen(command.c_str(), "r");
-    if (!pipe) {
-      cerr << "Failed to execute h5dump command" << endl;
-      return -1;
-    }
-
-    float value = 0;
-    char buffer[128];
-    if (fgets(buffer, sizeof(buffer), pipe)) {
-      value = strtof(buffer, nullptr);
-    }
-    pclose(pipe);
-
-    return (value <= 0) ? -1 : value;
-  }
-
 public:
   OptimizedAprobe(float lat, float lon, const string &prefix,
-                  const string &pathToData)
-      : lat(lat), lon(lon), prefix(prefix), pathToData(pathToData) {
+                  const string &pathToData, const string &outputDir,
+                  O3ExtractCache *cache = nullptr)
+      : lat(lat), lon(lon), prefix(prefix), pathToData(pathToData),
+        outputDir(outputDir), cache(cache) {
 
     // Ensure path ends with '/'
     if (!pathToData.empty() && pathToData.back() != '/') {
@@ -132,59 +55,23 @@ public:
     cout << "Processing Aprobe for location: " << prefix << " (Lat: " << lat
          << ", Lon: " << lon << ")" << endl;
 
-    if (!directoryExists(pathToData)) {
-      cerr << "Data path does not exist: " << pathToData << endl;
+    O3LocationSeries series;
+    auto extract = [&](O3LocationSeries &s) {
+      return o3ExtractOMI(pathToData, lat, lon, s);
+    };
+    if (!(cache ? cache->get(O3Source::OMI,
+                             o3SourceBin(O3Source::OMI, lat, lon), extract,
+                             series)
+                : extract(series))) {
       return false;
     }
 
-    int binLat = calculateLatBin(lat);
-    int binLon = calculateLonBin(lon);
-
-    cout << "Calculated bins - Lat: " << binLat << ", Lon: " << binLon << endl;
-
-    // Process years
-    for (int year = YMIN; year <= YMAX; ++year) {
-      cout << "Processing year: " << year << endl;
-
-      string outputFile = prefix + "_" + to_string(year) + ".dat";
-      ofstream outFile(outputFile);
-
-      if (!outFile.is_open()) {
-        cerr << "Cannot create output file: " << outputFile << endl;
-        continue;
-      }
-
-      // Use larger buffer for better performance
-      outFile.rdbuf()->pubsetbuf(nullptr, 8192);
-
-      vector<string> he5Files = getHE5Files(year);
-      cout << "Found " << he5Files.size() << " HE5 files" << endl;
-
-      if (he5Files.empty()) {
-        cout << "No HE5 files found for year " << year << endl;
-        continue;
-      }
-
-      for (const string &filename : he5Files) {
-        cout << "Processing: " << fs::path(filename).filename().string()
-             << endl;
-
-        DateInfo dateInfo = extractDate(filename);
-        if (!dateInfo.valid) {
-          cerr << "Could not extract date from: " << filename << endl;
-          continue;
-        }
-
-        float value = executeH5Dump(filename, binLat, binLon);
-
-        outFile << dateInfo.day << '\t' << dateInfo.month << '\t'
-                << dateInfo.year << '\t' << value << '\n';
-
-        cout << "Date: " << dateInfo.day << "/" << dateInfo.month << "/"
-             << dateInfo.year << ", Value: " << value << endl;
-      }
+    for (const auto &[year, rows] : series) {
+      cout << "Year " << year << ": " << rows.size() << " HE5 files" << endl;
+    }
 
-      cout << "Completed processing year " << year << endl;
+    if (!o3WriteYearFiles(outputDir, prefix, series)) {
+      return false;
     }
 
     cout << "Aprobe processing completed" << endl;
@@ -212,7 +99,7 @@ public:
 
 void printUsage() {
   cout << "Usage: optimized_aprobe -A<latitude> -B<longitude> -P<prefix> "
-          "-D<path_to_data>"
+          "-D<path_to_data> [-O<output_dir>] [-C<cache_dir>]"
        << endl;
   cout
       << "Example: optimized_aprobe -A4.36 -B-74.04 -PBOG -D/path/to/nasa/data/"
@@ -222,16 +109,24 @@ void printUsage() {
   cout << "  -B<lon>    Longitude (e.g., -B-74.04)" << endl;
   cout << "  -P<prefix> Location prefix (e.g., -PBOG)" << endl;
   cout << "  -D<path>   Path to NASA data directory" << endl;
+  cout << "  -O<dir>    Existing directory for the .dat files (default: .)"
+       << endl;
+  cout << "  -C<dir>    Extraction cache shared with optimized_ozone_processor"
+       << endl;
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 5) {
+  if (argc < 5 || argc > 7) {
     printUsage();
     return 1;
   }
+  // SIGINT/SIGTERM stop the extraction between files; nothing is written
+  o3InstallCancelHandlers();
 
   float lat = 0, lon = 0;
   string prefix, pathToData;
+  string outputDir = ".";
+  string cacheDir;
   bool hasLat = false, hasLon = false, hasPrefix = false, hasPath = false;
 
   for (int i = 1; i < argc; ++i) {
@@ -258,6 +153,12 @@ int main(int argc, char *argv[]) {
       pathToData = string(&argv[i][2]);
       hasPath = true;
       break;
+    case 'O':
+      outputDir = string(&argv[i][2]);
+      break;
+    case 'C':
+      cacheDir = string(&argv[i][2]);
+      break;
     default:
       cerr << "Error: Unknown option: " << argv[i] << endl;
       printUsage();
@@ -290,7 +191,17 @@ int main(int argc, char *argv[]) {
 
   auto start = chrono::high_resolution_clock::now();
 
-  OptimizedAprobe aprobe(lat, lon, prefix, pathToData);
+  unique_ptr<O3ExtractCache> cache;
+  if (!cacheDir.empty()) {
+    try {
+      cache.reset(new O3ExtractCache(cacheDir, pathToData));
+    } catch (const exception &e) {
+      cerr << "Error: " << e.what() << endl;
+      return 1;
+    }
+  }
+
+  OptimizedAprobe aprobe(lat, lon, prefix, pathToData, outputDir, cache.get());
 
   // Enable debug output for coordinate calculations
   aprobe.debugCoordinates();
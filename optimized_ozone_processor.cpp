@@ -1,14 +1,36 @@
+#include "include/o3Affinity.h"
+#include "include/o3Cancel.h"
+#include "include/o3Events.h"
+#include "include/o3ExtractCache.h"
+#include "include/o3Grid.h"
+#include "include/o3Manifest.h"
+#include "include/o3Pipeline.h"
+#include "include/o3Plan.h"
+#include "include/o3Priority.h"
+#include "include/o3Region.h"
+#include "include/o3Scheduler.h"
+#include "include/o3Shard.h"
+#include "include/o3SourceCache.h"
+#include "include/o3Stages.h"
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
-#include <future>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
-#include <unordered_set>
+#include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -17,72 +39,85 @@ class OptimizedOzoneDataProcessor {
 private:
   std::string pathO3Files;
   int evCut;
-  static std::mutex compilation_mutex;
-  static std::unordered_set<std::string> compiled_programs;
-
-  // Single compilation
-  bool compilePrograms() {
-    std::lock_guard<std::mutex> lock(compilation_mutex);
-
-    std::vector<std::pair<std::string, std::string>> programs = {
-        {"optimized_aprobe.cpp", "aprobe.exe"},
-        {"optimized_skim.cpp", "skim.exe"},
-        {"nmeprobeData.cpp", "nmprobe.exe"},
-        {"make_1995.cpp", "make_1995.exe"}};
-
-    for (const auto &[source, executable] : programs) {
-      // Skip if already compiled and executable exists
-      if (compiled_programs.count(executable) && fs::exists(executable)) {
-        continue;
-      }
-
-      // compilation
-      std::string command = "g++ -O3 -march=native -mtune=native -flto "
-                            "-funroll-loops -ffast-math -DNDEBUG "
-                            "-Wno-write-strings " +
-                            source + " -o " + executable;
+  bool externalTools = false;
+  std::string toolsDir;
+  // In process: also write the yearly files of <location>/ (--year-files);
+  // the stage executables always do
+  bool yearFiles = false;
+
+  // Days without satellite data and how the skim fills them (--gaps,
+  // --gap-fill); by default 1995 gets the placeholder
+  std::vector<O3DayRange> gaps{o3YearRange(1995)};
+  O3GapFill gapFill = O3GapFill::Marker;
+
+  // Staged pipeline (in process): workers per stage, 0 for the defaults
+  int ioWorkers = 0;
+  int cpuWorkers = 0;
+  int fitWorkers = 0;
+  std::string fitTool; // empty: no fit stage
+  double fitAlpha = 0;
+
+  O3Shard shard;
+  bool sharded = false;
+
+  // Worker pinning and NUMA placement (--pin); unpinned if unset
+  std::unique_ptr<O3Placement> placement;
+
+  // Processing order (--focus, --priority-file); original order if unset
+  std::unique_ptr<O3Focus> focus;
+  std::unique_ptr<std::unordered_map<std::string, size_t>> priorityRanks;
+
+  // Source bins shared by the locations of the current in-process run
+  std::unique_ptr<O3SourceCache> sources;
+
+  // Source bins kept across runs (--cache-dir); disabled if unset
+  std::unique_ptr<O3ExtractCache> extractCache;
+
+  // JSON-lines progress on --events-fd; counters of the current run
+  O3EventSink events;
+  std::chrono::steady_clock::time_point runStart;
+  size_t runTotal = 0;
+  std::atomic<size_t> runDone{0}, runFailed{0};
+
+  // Per-location progress, appended as locations start and finish
+  std::unique_ptr<O3Manifest> manifest;
+  bool resume = false;
+  uint64_t dataFingerprint = 0;
+  uint64_t settingsFingerprint = 0; // options that change the skim
+
+  // Prebuilt stage executable (make), searched in $O3_TOOLS_DIR, next to
+  // this program and in the working directory; empty if not found
+  std::string findTool(const std::string &name) const {
+    std::vector<fs::path> dirs;
+    if (const char *env = std::getenv("O3_TOOLS_DIR")) {
+      dirs.emplace_back(env);
+    }
+    if (!toolsDir.empty()) {
+      dirs.emplace_back(toolsDir);
+    }
+    dirs.emplace_back(".");
 
-      std::cout << "Compiling: " << command << std::endl;
-      int result = std::system(command.c_str());
-      if (result != 0) {
-        std::cerr << "Failed to compile: " << command << std::endl;
-        return false;
+    for (const auto &dir : dirs) {
+      fs::path candidate = dir / name;
+      if (fs::is_regular_file(candidate) &&
+          access(candidate.c_str(), X_OK) == 0) {
+        return candidate.string();
       }
-      compiled_programs.insert(executable);
     }
-    return true;
+    return "";
   }
 
-  // Thread-safe execution with unique temporary files
-  bool executeCommandThreadSafe(const std::string &command,
-                                const std::string &location) {
+  // Runs one stage executable; every stage writes only into the
+  // location's staging directory, so concurrent locations never share files.
+  // A command killed by Ctrl-C cancels the run (o3RunCommand).
+  bool executeCommandThreadSafe(const std::string &command) {
     std::cout << "Running (thread-safe): " << command << std::endl;
 
-    // Check if executable exists before running
-    std::string executable = command.substr(0, command.find(' '));
-    if (executable.length() >= 2 && executable.substr(0, 2) == "./") {
-      executable = executable.substr(2);
-    }
-
-    if (!fs::exists(executable)) {
-      std::cerr << "Executable not found: " << executable << std::endl;
+    int result = o3RunCommand(command);
+    if (result != 0 && o3Cancelled()) {
+      std::cerr << "Command cancelled: " << command << std::endl;
       return false;
     }
-
-    // Clean up potential leftover files that might cause issues
-    // Location-specific temporary file names to avoid thread conflicts
-    std::vector<std::string> tempFiles = {
-        "logLonLine_" + location + ".txt", "logLatLine_" + location + ".txt",
-        "list_" + location + ".txt", "logChkDir_" + location + ".txt"};
-
-    for (const auto &file : tempFiles) {
-      if (fs::exists(file)) {
-        fs::remove(file);
-        std::cout << "Cleaned up existing file: " << file << std::endl;
-      }
-    }
-
-    int result = std::system(command.c_str());
     if (result != 0) {
       std::cerr << "Command failed with code " << result << ": " << command
                 << std::endl;
@@ -101,38 +136,124 @@ private:
     return true;
   }
 
-  // file moving
-  bool moveDataFiles(const std::string &location) {
-    try {
-      fs::create_directories(location);
-
-      std::vector<fs::path> filesToMove;
-
-      // Collect files first to avoid iterator invalidation
-      for (const auto &entry : fs::directory_iterator(".")) {
-        if (entry.is_regular_file()) {
-          std::string filename = entry.path().filename().string();
-          if (filename.find(location + "_") == 0 &&
-              filename.find(".dat") != std::string::npos) {
-            filesToMove.push_back(entry.path());
-          }
-        }
-      }
+  void emitRunStart(const char *mode, size_t locations, size_t pending,
+                    int io, int cpu, int fit) {
+    runStart = std::chrono::steady_clock::now();
+    runTotal = pending;
+    runDone = 0;
+    runFailed = 0;
+    events.emit(O3Event("run_start")
+                    .str("mode", mode)
+                    .count("locations", locations)
+                    .count("pending", pending)
+                    .count("extract_workers", io)
+                    .count("skim_workers", cpu)
+                    .count("fit_workers", fit));
+  }
 
-      // Move files
-      for (const auto &filePath : filesToMove) {
-        std::string filename = filePath.filename().string();
-        fs::path destination = fs::path(location) / filename;
+  void emitTaskStart(const std::string &location) {
+    events.emit(O3Event("task_start").str("location", location));
+  }
 
-        if (fs::exists(destination)) {
-          fs::remove(destination); // Remove existing file
-        }
+  void emitStage(const std::string &location, const char *stage,
+                 double seconds, bool ok) {
+    events.emit(O3Event("stage")
+                    .str("location", location)
+                    .str("stage", stage)
+                    .num("seconds", seconds)
+                    .flag("ok", ok));
+  }
 
-        fs::rename(filePath, destination);
-        std::cout << "Moved: " << filename << " to " << location << "/"
-                  << std::endl;
+  void emitError(const std::string &location, const std::string &message) {
+    events.emit(
+        O3Event("error").str("location", location).str("message", message));
+  }
+
+  // task_end, then the run's progress with throughput and ETA; a task that
+  // did not finish because the run was cancelled is not counted as failed
+  void emitTaskEnd(const std::string &location, bool ok, double seconds) {
+    if (!events.enabled()) {
+      return;
+    }
+    const bool cancelled = !ok && o3Cancelled();
+    const size_t done = ++runDone;
+    const size_t failed =
+        ok || cancelled ? runFailed.load() : ++runFailed;
+    events.emit(O3Event("task_end")
+                    .str("location", location)
+                    .flag("ok", ok)
+                    .flag("cancelled", cancelled)
+                    .num("seconds", seconds));
+    const double elapsed = secondsSince(runStart);
+    const double rate = elapsed > 0 ? done / elapsed : 0;
+    events.emit(O3Event("progress")
+                    .count("done", done)
+                    .count("failed", failed)
+                    .count("total", runTotal)
+                    .num("elapsed", elapsed)
+                    .num("rate", rate)
+                    .num("eta", rate > 0 && done < runTotal
+                                    ? (runTotal - done) / rate
+                                    : 0)
+                    .count("bytes_read", o3ProcessBytesRead()));
+  }
+
+  void emitRunEnd(bool ok) {
+    events.emit(O3Event("run_end")
+                    .flag("ok", ok)
+                    .flag("cancelled", o3Cancelled())
+                    .count("done", runDone)
+                    .count("failed", runFailed)
+                    .num("seconds", secondsSince(runStart))
+                    .count("bytes_read", o3ProcessBytesRead()));
+  }
+
+  // This shard's part of locations in processing order; the list is also
+  // written to the shard plan for ozone_merge
+  bool selectShard(const std::vector<O3Location> &all,
+                   std::vector<O3Location> &locations) const {
+    if (!sharded) {
+      locations = all;
+    } else {
+      locations = o3ShardLocations(all, shard);
+      std::cout << "Shard " << shard.index << "/" << shard.count << ": "
+                << locations.size() << " of " << all.size() << " locations"
+                << std::endl;
+      if (!o3WriteShardPlan(O3_SHARD_PLAN_NAME, shard, locations)) {
+        std::cerr << "Cannot write " << O3_SHARD_PLAN_NAME << std::endl;
+        return false;
       }
+    }
+    if ((focus || priorityRanks) && !locations.empty()) {
+      o3PrioritizeLocations(locations, focus.get(), priorityRanks.get());
+      std::cout << "Priority order: " << locations.front().name
+                << " first" << std::endl;
+    }
+    return true;
+  }
+
+  // Private, empty directory the yearly files of a location are written to
+  // before they replace <location>/
+  static std::string stagingDir(const std::string &location) {
+    return location + ".partial";
+  }
 
+  bool createStagingDir(const std::string &location) {
+    try {
+      fs::remove_all(stagingDir(location));
+      fs::create_directories(stagingDir(location));
+      return true;
+    } catch (const fs::filesystem_error &ex) {
+      std::cerr << "Filesystem error: " << ex.what() << std::endl;
+      return false;
+    }
+  }
+
+  // Replaces <location>/ with the completed staging directory
+  bool commitStagingDir(const std::string &location) {
+    try {
+      fs::remove_all(location);
+      fs::rename(stagingDir(location), location);
       return true;
     } catch (const fs::filesystem_error &ex) {
       std::cerr << "Filesystem error: " << ex.what() << std::endl;
@@ -148,6 +269,256 @@ public:
     if (!pathO3Files.empty() && pathO3Files.back() != '/') {
       pathO3Files += '/';
     }
+    // Folder of this executable, where make puts the stage executables
+    std::error_code ec;
+    fs::path self = fs::read_symlink("/proc/self/exe", ec);
+    if (!ec) {
+      toolsDir = self.parent_path().string();
+    }
+  }
+
+  // Run the aprobe/nmprobe/make_1995/skim executables instead of the
+  // in-process stages
+  void setExternalTools(bool enable) { externalTools = enable; }
+
+  // Keep the yearly files of in-process runs, for skim.exe or inspection
+  void setYearFiles(bool enable) { yearFiles = enable; }
+
+  // Fills every gap of the data catalog (not only 1995) and/or estimates
+  // the gap days; in process only, skim.exe keeps the placeholder year
+  bool setGapFill(O3GapFill mode, bool catalogGaps) {
+    if (externalTools && (catalogGaps || mode != O3GapFill::Marker)) {
+      std::cerr << "--gaps and --gap-fill need the in-process pipeline"
+                << std::endl;
+      return false;
+    }
+    gapFill = mode;
+    if (catalogGaps) {
+      gaps = o3CatalogGaps(pathO3Files);
+      int64_t days = 0;
+      for (const O3DayRange &g : gaps) {
+        days += g.last - g.first + 1;
+      }
+      std::cout << "Gaps in the data catalog: " << gaps.size()
+                << " ranges, " << days << " days" << std::endl;
+    }
+    return true;
+  }
+
+  // Process only this shard of every location list
+  void setShard(const O3Shard &s) {
+    shard = s;
+    sharded = true;
+  }
+
+  // Pins the workers of parallel runs to cores or NUMA nodes
+  void setPlacement(O3PinMode mode) {
+    if (mode == O3PinMode::None) {
+      placement.reset();
+    } else {
+      placement.reset(new O3Placement(mode));
+    }
+  }
+
+  // Locations nearest the focus point or box first
+  void setFocus(const O3Focus &f) { focus.reset(new O3Focus(f)); }
+
+  // Names listed in a priority file first, in file order
+  bool setPriorityFile(const std::string &path) {
+    std::string error;
+    priorityRanks.reset(new std::unordered_map<std::string, size_t>);
+    if (!o3ReadPriorityFile(path, *priorityRanks, error)) {
+      std::cerr << error << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Reuses source bins extracted by earlier runs from cacheDir, and adds
+  // the ones this run extracts
+  bool setExtractCache(const std::string &cacheDir) {
+    try {
+      extractCache.reset(new O3ExtractCache(cacheDir, pathO3Files));
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  void printExtractCache() const {
+    if (extractCache && !externalTools) {
+      extractCache->printSummary(std::cout);
+    }
+  }
+
+  // JSON-lines events on an open descriptor (--events-fd)
+  bool setEventsFd(int fd) {
+    if (!events.open(fd)) {
+      std::cerr << "Events descriptor " << fd << " is not open" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Worker counts of the in-process extract (I/O) and skim (CPU) stages;
+  // 0 keeps the defaults (the thread argument, and half of it)
+  void setStageWorkers(int io, int cpu) {
+    ioWorkers = io;
+    cpuWorkers = cpu;
+  }
+
+  // Runs chi2LRSO3vsSnRunApp -E<cutoff> -N<location> -I<alpha> on every
+  // finished location; workers 0 means one per hardware thread
+  bool enableFit(double alpha, int workers) {
+    fitTool = findTool("chi2LRSO3vsSnRunApp");
+    if (fitTool.empty()) {
+      std::cerr << "chi2LRSO3vsSnRunApp not found; build it with make root "
+                   "or set O3_TOOLS_DIR"
+                << std::endl;
+      return false;
+    }
+    fitAlpha = alpha;
+    fitWorkers = workers;
+    return true;
+  }
+
+  // Records every location in the manifest; with resume, locations the
+  // manifest lists as done (same inputs, output intact) are skipped
+  bool openManifest(const std::string &path, bool resumeRun) {
+    try {
+      manifest.reset(new O3Manifest(path));
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+    resume = resumeRun;
+    dataFingerprint = sourcesFingerprint();
+    settingsFingerprint = o3Hash64(settingsKey());
+    return true;
+  }
+
+  // Names, sizes and mtimes of every data file (o3ScanSources), so a file
+  // added, removed or rewritten in place changes it
+  uint64_t sourcesFingerprint() const {
+    O3SourceFiles files[4];
+    o3ScanSources(pathO3Files, files);
+    std::string key;
+    for (const O3SourceFiles &f : files) {
+      key += std::to_string(f.fingerprint) + " ";
+    }
+    return o3Hash64(key);
+  }
+
+  // The options a location's outputs depend on, so --resume redoes
+  // locations processed with another gap policy or output layout
+  std::string settingsKey() const {
+    std::string key = "fill " + std::to_string(static_cast<int>(gapFill)) +
+                      " yearfiles " + std::to_string(yearFiles) +
+                      " external " + std::to_string(externalTools) + " gaps";
+    for (const O3DayRange &g : gaps) {
+      key += " " + std::to_string(g.first) + "-" + std::to_string(g.last);
+    }
+    return key;
+  }
+
+  uint64_t inputFingerprint(double lat, double lon) const {
+    char key[128];
+    std::snprintf(key, sizeof(key), "%.6f %.6f %016llx %016llx", lat, lon,
+                  static_cast<unsigned long long>(dataFingerprint),
+                  static_cast<unsigned long long>(settingsFingerprint));
+    return o3Hash64(key);
+  }
+
+  static std::string skimPath(const std::string &location) {
+    return "skim_" + location + "/" + location + ".dat";
+  }
+
+  bool isComplete(const std::string &location, double lat, double lon) const {
+    return manifest && resume &&
+           manifest->isDone(location, inputFingerprint(lat, lon),
+                            skimPath(location));
+  }
+
+  // Appends the start record of a location; returned for endRecord
+  O3ManifestRecord beginRecord(const std::string &location, double lat,
+                               double lon) {
+    O3ManifestRecord rec;
+    rec.input = inputFingerprint(lat, lon);
+    rec.status = "start";
+    if (manifest) {
+      manifest->append(location, rec);
+    }
+    return rec;
+  }
+
+  // Appends the done/failed record; seconds is the time spent working on
+  // the location, excluding time waiting in stage queues. A location that
+  // did not finish leaves nothing behind: its staging directory is removed
+  // and the previous <location>/, if any, is untouched.
+  void endRecord(const std::string &location, O3ManifestRecord rec, bool ok,
+                 double seconds) {
+    if (!ok) {
+      std::error_code ec;
+      fs::remove_all(stagingDir(location), ec);
+    }
+    if (!manifest) {
+      return;
+    }
+    rec.seconds = seconds;
+    if (ok) {
+      rec.output = o3FileChecksum(skimPath(location), &rec.outputBytes);
+      rec.status = "done";
+    } else {
+      rec.status = o3Cancelled() ? "cancelled" : "failed";
+    }
+    manifest->append(location, rec);
+  }
+
+  static double secondsSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         t0)
+        .count();
+  }
+
+  // processLocation with start/done/failed records in the manifest, then
+  // the fit if enabled
+  bool runLocation(const std::string &location, double lat, double lon) {
+    emitTaskStart(location);
+    O3ManifestRecord rec = beginRecord(location, lat, lon);
+    auto start = std::chrono::steady_clock::now();
+    bool ok = processLocation(location, lat, lon);
+    const double seconds = secondsSince(start);
+    endRecord(location, rec, ok, seconds);
+    emitStage(location, "process", seconds, ok);
+    if (ok && !fitTool.empty()) {
+      auto t0 = std::chrono::steady_clock::now();
+      ok = runFit(location);
+      emitStage(location, "fit", secondsSince(t0), ok);
+    }
+    emitTaskEnd(location, ok, secondsSince(start));
+    return ok;
+  }
+
+  // location mode: runLocation as a run of one
+  bool runSingleLocation(const std::string &location, double lat,
+                         double lon) {
+    emitRunStart("location", 1, 1, 1, 1, fitTool.empty() ? 0 : 1);
+    const bool ok = runLocation(location, lat, lon);
+    printExtractCache();
+    emitRunEnd(ok);
+    return ok;
+  }
+
+  // chi2 linear fit of a finished location (chi2LRSO3vsSnRunApp reads
+  // skim_<location>/ and snData/ from the working directory); its output
+  // goes to skim_<location>/<location>_fit.log
+  bool runFit(const std::string &location) {
+    std::ostringstream cmd;
+    cmd << fitTool << " -E" << evCut << " -N" << location << " -I"
+        << fitAlpha << " > skim_" << location << "/" << location
+        << "_fit.log 2>&1";
+    return executeCommandThreadSafe(cmd.str());
   }
 
   bool processLocation(const std::string &location, double lat, double lon) {
@@ -155,39 +526,48 @@ public:
               << std::setprecision(6) << lat << ", Lon: " << lon << ")"
               << std::endl;
 
-    // Compile programs once
-    if (!compilePrograms()) {
+    if (!externalTools) {
+      return processLocationInProcess(location, lat, lon);
+    }
+
+    const std::string aprobe = findTool("aprobe.exe");
+    const std::string nmprobe = findTool("nmprobe.exe");
+    const std::string make1995 = findTool("make_1995.exe");
+    const std::string skim = findTool("skim.exe");
+    if (aprobe.empty() || nmprobe.empty() || make1995.empty() ||
+        skim.empty()) {
+      std::cerr << "Stage executables not found (aprobe.exe, nmprobe.exe, "
+                   "make_1995.exe, skim.exe); build them with make or set "
+                   "O3_TOOLS_DIR"
+                << std::endl;
       return false;
     }
 
+    if (!createStagingDir(location)) {
+      return false;
+    }
+    const std::string outDir = " -O" + stagingDir(location);
+
     // Use higher precision for coordinates to avoid floating point issues
     std::ostringstream args;
     args << " -A" << std::fixed << std::setprecision(6) << lat << " -B"
          << std::fixed << std::setprecision(6) << lon << " -P" << location
-         << " -D" << pathO3Files;
+         << " -D" << pathO3Files << outDir;
+    const std::string cacheArg =
+        extractCache ? " -C" + extractCache->directory() : "";
+    args << cacheArg;
 
     std::string argsStr = args.str();
     std::cout << "Parameters for cpp codes: " << argsStr << std::endl;
 
     // Run aprobe.exe
-    if (!executeCommandThreadSafe("./aprobe.exe" + argsStr, location)) {
+    if (!executeCommandThreadSafe(aprobe + argsStr)) {
       return false;
     }
 
     // Check if aprobe.exe produced expected output files before proceeding
-    bool foundOutputFiles = false;
-    for (const auto &entry : fs::directory_iterator(".")) {
-      if (entry.is_regular_file()) {
-        std::string filename = entry.path().filename().string();
-        if (filename.find(location + "_") == 0 &&
-            filename.find(".dat") != std::string::npos) {
-          foundOutputFiles = true;
-          break;
-        }
-      }
-    }
-
-    if (!foundOutputFiles) {
+    std::error_code ec;
+    if (fs::is_empty(stagingDir(location), ec) || ec) {
       std::cerr << "No output files found from aprobe.exe for location: "
                 << location << std::endl;
       std::cerr << "Skipping nmprobe.exe execution to avoid crashes"
@@ -200,162 +580,655 @@ public:
       std::ostringstream nmprobeArgs;
       nmprobeArgs << " -A" << std::fixed << std::setprecision(6) << lat << " -B"
                   << std::fixed << std::setprecision(6) << lon << " -P"
-                  << location << " -S" << s << " -D" << pathO3Files;
+                  << location << " -S" << s << " -D" << pathO3Files
+                  << outDir << cacheArg;
 
       std::cout << "Attempting to run nmprobe.exe with -S" << s << std::endl;
 
       // Use thread-safe execution to avoid conflicts between parallel processes
-      if (!executeCommandThreadSafe("./nmprobe.exe" + nmprobeArgs.str(),
-                                    location)) {
-        std::cerr << "nmprobe.exe failed with -S" << s
-                  << " for location: " << location << std::endl;
+      if (!executeCommandThreadSafe(nmprobe + nmprobeArgs.str())) {
+        if (!o3Cancelled()) {
+          std::cerr << "nmprobe.exe failed with -S" << s
+                    << " for location: " << location << std::endl;
+        }
         return false;
       }
     }
 
     // Run make_1995.exe
-    if (!executeCommandThreadSafe("./make_1995.exe -P" + location, location)) {
+    if (!executeCommandThreadSafe(make1995 + " -P" + location + outDir)) {
       return false;
     }
 
-    // Move files to directory
-    if (!moveDataFiles(location)) {
+    // All yearly files written: publish them as <location>/
+    if (!commitStagingDir(location)) {
       return false;
     }
 
     // Run skim.exe
-    if (!executeCommandThreadSafe("./skim.exe -P" + location, location)) {
+    if (!executeCommandThreadSafe(skim + " -P" + location)) {
       return false;
     }
 
     return true;
   }
 
-  // Parallel grid processing
-  bool processGridParallel(int latMin, int latMax, int lonMin, int lonMax,
-                           int gridPrecision, int numThreads = 0) {
+  // Same stages as processLocation, called as functions: the extracted
+  // series goes straight into the skim array, only the skim (and, with
+  // --year-files, the yearly files) touch the disk
+  bool processLocationInProcess(const std::string &location, double lat,
+                                double lon) {
+    O3SkimSeries skim;
+    return extractLocation(location, lat, lon, skim) &&
+           skimLocation(location, skim);
+  }
+
+  // One satellite source of a location, through the run's source cache
+  // when the locations were planned and the extraction cache if enabled
+  bool extractSource(O3Source source, double lat, double lon,
+                     const std::function<bool(O3LocationSeries &)> &extract,
+                     O3LocationSeries &series) {
+    const uint64_t bin = o3SourceBin(source, lat, lon);
+    std::function<bool(O3LocationSeries &)> read = extract;
+    if (extractCache) {
+      read = [&](O3LocationSeries &s) {
+        return extractCache->get(source, bin, extract, s);
+      };
+    }
+    if (!sources) {
+      return read(series);
+    }
+    return sources->get(bin, read, series);
+  }
+
+  // Registers the source bins of the locations to be extracted, so each
+  // bin is read once and shared (LON180 and LON-180, points in one bin)
+  void planSources(const std::vector<O3Location> &locations,
+                   const std::vector<size_t> &pending) {
+    sources.reset(new O3SourceCache);
+    const O3Source all[] = {O3Source::OMI, O3Source::Nimbus7,
+                            O3Source::Meteor3, O3Source::EarthProbe};
+    for (size_t i : pending) {
+      for (O3Source source : all) {
+        sources->plan(o3SourceBin(source, locations[i].lat, locations[i].lon));
+      }
+    }
+  }
+
+  // I/O stage: reads every satellite source and fills the day-indexed
+  // skim of the location; with --year-files also writes <location>/
+  bool extractLocation(const std::string &location, double lat, double lon,
+                       O3SkimSeries &skim) {
+    O3LocationSeries series;
+    auto omi = [&](O3LocationSeries &s) {
+      return o3ExtractOMI(pathO3Files, lat, lon, s);
+    };
+    if (!extractSource(O3Source::OMI, lat, lon, omi, series)) {
+      std::cerr << "OMI extraction failed for location: " << location
+                << std::endl;
+      return false;
+    }
+
+    const O3TomsSatellite satellites[] = {O3TomsSatellite::Nimbus7,
+                                          O3TomsSatellite::Meteor3,
+                                          O3TomsSatellite::EarthProbe};
+    for (O3TomsSatellite sat : satellites) {
+      auto toms = [&](O3LocationSeries &s) {
+        return o3ExtractTOMS(pathO3Files, lat, lon, sat, s);
+      };
+      if (!extractSource(static_cast<O3Source>(sat), lat, lon, toms,
+                         series)) {
+        std::cerr << "TOMS extraction failed with -S" << static_cast<int>(sat)
+                  << " for location: " << location << std::endl;
+        return false;
+      }
+    }
+
+    if (yearFiles) {
+      // 1995 has no TOMS data; the yearly files hold a placeholder year
+      o3FillYear(1995, O3_PLACEHOLDER, series);
+      if (!createStagingDir(location) ||
+          !o3WriteYearFiles(stagingDir(location), location, series) ||
+          !commitStagingDir(location)) {
+        return false;
+      }
+    }
+    skim = o3Skim(series);
+    o3FillGaps(skim, gaps, gapFill);
+    return true;
+  }
+
+  // CPU stage: the skim written to skim_<location>/ in one piece
+  bool skimLocation(const std::string &location, const O3SkimSeries &skim) {
+    if (!o3WriteSkim(location, skim)) {
+      return false;
+    }
+
+    std::cout << "Location " << location << ": " << skim.years.size()
+              << " years, " << skim.values.size() << " days";
+    const size_t estimated =
+        std::count(skim.filled.begin(), skim.filled.end(), 1);
+    if (estimated > 0) {
+      std::cout << " (" << estimated << " filled)";
+    }
+    std::cout << std::endl;
+    return true;
+  }
+
+  // Parallel processing of any location list (grid cells, points or
+  // polygon cells)
+  bool processLocationsParallel(const std::vector<O3Location> &allLocations,
+                                int numThreads = 0) {
+    std::vector<O3Location> locations;
+    if (!selectShard(allLocations, locations)) {
+      return false;
+    }
 
     if (numThreads == 0) {
       numThreads =
           std::min(static_cast<int>(std::thread::hardware_concurrency()), 8);
     }
 
-    std::cout << "Processing grid with " << numThreads << " threads: "
-              << "Lat[" << latMin << "," << latMax << "], "
-              << "Lon[" << lonMin << "," << lonMax << "], "
-              << "Precision: " << gridPrecision << std::endl;
-
-    // Generate all coordinate pairs
-    std::vector<std::pair<int, int>> coordinates;
-    for (int lon = lonMin; lon <= lonMax; lon += gridPrecision) {
-      for (int lat = latMin; lat <= latMax; lat += gridPrecision) {
-        coordinates.emplace_back(lat, lon);
+    std::cout << "Processing " << locations.size() << " locations with "
+              << numThreads << " threads" << std::endl;
+
+    // Per-location outcome, indexed like locations (0 pending, 1 done,
+    // 2 failed)
+    std::vector<char> status(locations.size(), 0);
+
+    // Locations finished by an earlier run are not scheduled again
+    std::vector<size_t> pending;
+    pending.reserve(locations.size());
+    for (size_t i = 0; i < locations.size(); ++i) {
+      const O3Location &loc = locations[i];
+      if (isComplete(loc.name, loc.lat, loc.lon)) {
+        status[i] = 1;
+      } else {
+        pending.push_back(i);
       }
     }
+    if (pending.size() < locations.size()) {
+      std::cout << "Resuming: " << locations.size() - pending.size()
+                << " locations already complete" << std::endl;
+    }
 
-    std::cout << "Total locations to process: " << coordinates.size()
+    std::cout << "Total locations to process: " << pending.size()
               << std::endl;
 
-    // Process in parallel chunks
-    std::vector<std::future<bool>> futures;
+    bool ok;
+    if (externalTools) {
+      ok = runScheduled(locations, pending, status, numThreads);
+    } else {
+      planSources(locations, pending);
+      ok = runStaged(locations, pending, status, numThreads);
+      sources->printSummary(std::cout);
+      sources.reset();
+      printExtractCache();
+    }
+
+    // Check results; locations never started (cancelled) are left pending
+    size_t failed = 0, notRun = 0;
+    for (char st : status) {
+      if (st == 0) {
+        ++notRun;
+      } else if (st != 1) {
+        ++failed;
+      }
+    }
+    if (failed > 0 && !o3Cancelled()) {
+      std::cerr << failed << " of " << locations.size()
+                << " locations failed" << std::endl;
+    }
+    if (o3Cancelled()) {
+      std::cerr << "Cancelled: " << locations.size() - failed - notRun
+                << " of " << locations.size() << " locations done, "
+                << failed + notRun << " left for --resume" << std::endl;
+    }
+
+    ok = ok && failed == 0 && notRun == 0;
+    emitRunEnd(ok);
+    return ok;
+  }
+
+  // External tools: one task per location on the work-stealing scheduler
+  bool runScheduled(const std::vector<O3Location> &locations,
+                    const std::vector<size_t> &pending,
+                    std::vector<char> &status, int numThreads) {
     std::mutex output_mutex;
     size_t completed = 0;
-    size_t total_coords = coordinates.size();
+    const size_t total_coords = pending.size();
+    emitRunStart("external", locations.size(), pending.size(), numThreads, 0,
+                 fitTool.empty() ? 0 : numThreads);
+
+    // Worker w runs on node w % nodes; its children inherit the CPUs
+    std::vector<char> pinned(numThreads, 0);
+    if (placement) {
+      std::cout << "Placement: " << placement->describe() << std::endl;
+    }
 
-    auto processChunk =
-        [this, &output_mutex, &completed,
-         total_coords](const std::vector<std::pair<int, int>> &chunk) -> bool {
-      bool allSuccess = true;
+    // One task per location; idle workers steal from busy ones
+    O3Scheduler scheduler(numThreads);
+    scheduler.run(pending.size(), [&](size_t task, int worker) {
+      if (o3Cancelled()) {
+        return;
+      }
+      if (placement && !pinned[worker]) {
+        placement->pinToNode(worker % placement->nodes());
+        pinned[worker] = 1;
+      }
+      const size_t i = pending[task];
+      const O3Location &loc = locations[i];
+
+      {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << "Processing: " << loc.name << " (" << ++completed << "/"
+                  << total_coords << ")" << std::endl;
+      }
 
-      for (const auto &[lat, lon] : chunk) {
-        std::string location =
-            "LAT" + std::to_string(lat) + "LON" + std::to_string(lon);
+      if (runLocation(loc.name, loc.lat, loc.lon)) {
+        status[i] = 1;
+      } else if (o3Cancelled()) {
+        // Stopped by the cancel (recorded as cancelled): left pending
+      } else {
+        status[i] = 2;
+        emitError(loc.name, "processing failed");
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cerr << "Failed to process location: " << loc.name << std::endl;
+      }
+    });
 
+    scheduler.printUtilization(std::cout);
+    return true;
+  }
+
+  // In process: extraction workers (I/O bound) feed skim workers through a
+  // bounded queue, skim workers feed the fit workers through another. Each
+  // stage has its own worker count; full queues block the stage before.
+  //
+  // With --pin the workers of every stage are spread over the NUMA nodes
+  // (worker w on node w % nodes). Node k extracts the pending locations
+  // t with t % nodes == k, in order, and takes the other nodes' once its
+  // own run out; its series go through its own skim queue to skim workers
+  // on the same node, so they are allocated and read on one node.
+  bool runStaged(const std::vector<O3Location> &locations,
+                 const std::vector<size_t> &pending, std::vector<char> &status,
+                 int numThreads) {
+    const int hardware =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int numIo = ioWorkers > 0 ? ioWorkers : numThreads;
+    const int numNodes = placement ? std::min(placement->nodes(), numIo) : 1;
+    // Every node that extracts needs a skim worker
+    const int numCpu = std::max(
+        cpuWorkers > 0 ? cpuWorkers : std::max(1, numIo / 2), numNodes);
+    const int numFit =
+        fitTool.empty() ? 0 : (fitWorkers > 0 ? fitWorkers : hardware);
+
+    std::cout << "Stages: " << numIo << " extract, " << numCpu << " skim, "
+              << numFit << " fit workers" << std::endl;
+    if (placement) {
+      std::cout << "Placement: " << placement->describe() << std::endl;
+    }
+    emitRunStart("staged", locations.size(), pending.size(), numIo, numCpu,
+                 numFit);
+
+    struct Extracted {
+      size_t index = 0;
+      O3SkimSeries skim;
+      O3ManifestRecord rec;
+      double seconds = 0;
+    };
+    // One skim queue per node, fed by the node's extract workers
+    auto workersOn = [&](int workers, int node) {
+      return workers / numNodes + (node < workers % numNodes ? 1 : 0);
+    };
+    std::vector<std::unique_ptr<O3BoundedQueue<Extracted>>> toSkim;
+    for (int k = 0; k < numNodes; ++k) {
+      toSkim.emplace_back(new O3BoundedQueue<Extracted>(
+          2 * workersOn(numCpu, k), workersOn(numIo, k)));
+    }
+    // Location index and its extract + skim seconds
+    O3BoundedQueue<std::pair<size_t, double>> toFit(2 * std::max(numFit, 1),
+                                                    numCpu);
+
+    O3StageStats stages[3];
+    stages[0].name = "extract";
+    stages[0].workers = numIo;
+    stages[1].name = "skim";
+    stages[1].workers = numCpu;
+    stages[2].name = "fit";
+    stages[2].workers = numFit;
+
+    std::mutex output_mutex;
+    // Next task of each node: node k owns tasks k, k + nodes, ...
+    std::vector<std::atomic<size_t>> next(numNodes);
+    size_t completed = 0;
+    size_t fitFailed = 0;
+    size_t fitSkipped = 0;
+    const size_t total_coords = pending.size();
+
+    auto addStats = [&](int stage, size_t items, double busy) {
+      std::lock_guard<std::mutex> lock(output_mutex);
+      stages[stage].items += items;
+      stages[stage].busySeconds += busy;
+    };
+
+    auto pin = [&](int worker) {
+      if (placement) {
+        placement->pinToNode(worker % numNodes);
+      }
+    };
+
+    // The node's next task, or another node's if it has none left
+    auto claim = [&](int node, size_t &task) {
+      for (int d = 0; d < numNodes; ++d) {
+        const int k = (node + d) % numNodes;
+        task = k + next[k]++ * numNodes;
+        if (task < pending.size()) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    auto extractWorker = [&](int worker) {
+      pin(worker);
+      const int node = worker % numNodes;
+      size_t items = 0;
+      double busy = 0;
+      // No new locations once the run is cancelled
+      for (size_t task; !o3Cancelled() && claim(node, task);) {
+        const size_t i = pending[task];
+        const O3Location &loc = locations[i];
         {
           std::lock_guard<std::mutex> lock(output_mutex);
-          std::cout << "Processing: " << location << " (" << ++completed << "/"
-                    << total_coords << ")" << std::endl;
+          std::cout << "Processing: " << loc.name << " (" << ++completed
+                    << "/" << total_coords << ")" << std::endl;
         }
+        emitTaskStart(loc.name);
+
+        auto t0 = std::chrono::steady_clock::now();
+        Extracted item;
+        item.index = i;
+        item.rec = beginRecord(loc.name, loc.lat, loc.lon);
+        bool ok = extractLocation(loc.name, loc.lat, loc.lon, item.skim);
+        item.seconds = secondsSince(t0);
+        busy += item.seconds;
+        ++items;
+        emitStage(loc.name, "extract", item.seconds, ok);
+
+        if (ok) {
+          toSkim[node]->push(std::move(item));
+        } else {
+          status[i] = 2;
+          endRecord(loc.name, item.rec, false, item.seconds);
+          emitError(loc.name, "extraction failed");
+          emitTaskEnd(loc.name, false, item.seconds);
+          std::lock_guard<std::mutex> lock(output_mutex);
+          std::cerr << "Failed to process location: " << loc.name
+                    << std::endl;
+        }
+      }
+      toSkim[node]->done();
+      addStats(0, items, busy);
+    };
 
-        if (!processLocation(location, lat, lon)) {
+    auto skimWorker = [&](int worker) {
+      pin(worker);
+      O3BoundedQueue<Extracted> &queue = *toSkim[worker % numNodes];
+      size_t items = 0;
+      double busy = 0;
+      Extracted item;
+      while (queue.pop(item)) {
+        const O3Location &loc = locations[item.index];
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = skimLocation(loc.name, item.skim);
+        item.skim = O3SkimSeries();
+        const double seconds = secondsSince(t0);
+        busy += seconds;
+        ++items;
+
+        endRecord(loc.name, item.rec, ok, item.seconds + seconds);
+        emitStage(loc.name, "skim", seconds, ok);
+        status[item.index] = ok ? 1 : 2;
+        if (!ok) {
+          emitError(loc.name, "skim failed");
+          emitTaskEnd(loc.name, false, item.seconds + seconds);
           std::lock_guard<std::mutex> lock(output_mutex);
-          std::cerr << "Failed to process location: " << location << std::endl;
-          allSuccess = false;
+          std::cerr << "Failed to process location: " << loc.name
+                    << std::endl;
+        } else if (numFit > 0) {
+          toFit.push({item.index, item.seconds + seconds});
+        } else {
+          emitTaskEnd(loc.name, true, item.seconds + seconds);
         }
       }
+      toFit.done();
+      addStats(1, items, busy);
+    };
 
-      return allSuccess;
+    auto fitWorker = [&](int worker) {
+      pin(worker);
+      size_t items = 0;
+      double busy = 0;
+      std::pair<size_t, double> task;
+      while (toFit.pop(task)) {
+        const size_t i = task.first;
+        if (o3Cancelled()) {
+          // The skim is done and recorded; analysis_runner can fit it later
+          emitError(locations[i].name, "fit skipped (cancelled)");
+          emitTaskEnd(locations[i].name, false, task.second);
+          std::lock_guard<std::mutex> lock(output_mutex);
+          ++fitSkipped;
+          continue;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = runFit(locations[i].name);
+        const double seconds = secondsSince(t0);
+        busy += seconds;
+        ++items;
+        emitStage(locations[i].name, "fit", seconds, ok);
+        emitTaskEnd(locations[i].name, ok, task.second + seconds);
+        if (!ok && o3Cancelled()) {
+          // Killed by Ctrl-C: left for analysis_runner like a skipped fit
+          std::lock_guard<std::mutex> lock(output_mutex);
+          ++fitSkipped;
+        } else if (!ok) {
+          emitError(locations[i].name, "fit failed");
+          std::lock_guard<std::mutex> lock(output_mutex);
+          ++fitFailed;
+          std::cerr << "Fit failed for location: " << locations[i].name
+                    << std::endl;
+        }
+      }
+      addStats(2, items, busy);
     };
 
-    // Divide work among threads
-    size_t chunkSize = (coordinates.size() + numThreads - 1) / numThreads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < numIo; ++w) {
+      threads.emplace_back(extractWorker, w);
+    }
+    for (int w = 0; w < numCpu; ++w) {
+      threads.emplace_back(skimWorker, w);
+    }
+    for (int w = 0; w < numFit; ++w) {
+      threads.emplace_back(fitWorker, w);
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
 
-    for (int i = 0; i < numThreads && i * chunkSize < coordinates.size(); ++i) {
-      size_t start = i * chunkSize;
-      size_t end = std::min(start + chunkSize, coordinates.size());
+    o3PrintStages(std::cout, stages, numFit > 0 ? 3 : 2, secondsSince(start));
+    double pushWait = 0;
+    for (const auto &queue : toSkim) {
+      pushWait += queue->pushWaitSeconds();
+    }
+    std::cout << "Extract workers blocked on a full skim queue: " << std::fixed
+              << std::setprecision(1) << pushWait
+              << " thread-seconds" << std::endl;
 
-      std::vector<std::pair<int, int>> chunk(coordinates.begin() + start,
-                                             coordinates.begin() + end);
+    if (fitFailed > 0) {
+      std::cerr << fitFailed << " fits failed" << std::endl;
+    }
+    if (fitSkipped > 0) {
+      std::cerr << fitSkipped << " fits skipped after cancel" << std::endl;
+    }
+    return fitFailed == 0 && fitSkipped == 0;
+  }
 
-      futures.push_back(std::async(std::launch::async, processChunk, chunk));
+  // Sequential processing; stops at the first failure
+  bool processLocations(const std::vector<O3Location> &allLocations) {
+    std::vector<O3Location> locations;
+    if (!selectShard(allLocations, locations)) {
+      return false;
     }
 
-    // Wait for all threads to complete and check results
-    bool allSuccess = true;
-    for (auto &future : futures) {
-      if (!future.get()) {
-        allSuccess = false;
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < locations.size(); ++i) {
+      if (!isComplete(locations[i].name, locations[i].lat,
+                      locations[i].lon)) {
+        pending.push_back(i);
       }
     }
+    if (!externalTools) {
+      planSources(locations, pending);
+    }
+    emitRunStart("sequential", locations.size(), pending.size(), 1, 1,
+                 fitTool.empty() ? 0 : 1);
 
-    return allSuccess;
-  }
-
-  // Sequential processing
-  bool processGrid(int latMin, int latMax, int lonMin, int lonMax,
-                   int gridPrecision) {
-    std::cout << "Processing grid sequentially: Lat[" << latMin << "," << latMax
-              << "], "
-              << "Lon[" << lonMin << "," << lonMax << "], "
-              << "Precision: " << gridPrecision << std::endl;
-
-    size_t totalLocations = ((latMax - latMin) / gridPrecision + 1) *
-                            ((lonMax - lonMin) / gridPrecision + 1);
+    bool ok = true;
     size_t processed = 0;
+    for (const O3Location &loc : locations) {
+      if (o3Cancelled()) {
+        ok = false;
+        break;
+      }
+      if (isComplete(loc.name, loc.lat, loc.lon)) {
+        std::cout << "Already complete: " << loc.name << " (" << ++processed
+                  << "/" << locations.size() << ")" << std::endl;
+        continue;
+      }
 
-    for (int lon = lonMin; lon <= lonMax; lon += gridPrecision) {
-      for (int lat = latMin; lat <= latMax; lat += gridPrecision) {
-        std::string location =
-            "LAT" + std::to_string(lat) + "LON" + std::to_string(lon);
-
-        std::cout << "Processing: " << location << " (" << ++processed << "/"
-                  << totalLocations << ")" << std::endl;
+      std::cout << "Processing: " << loc.name << " (" << ++processed << "/"
+                << locations.size() << ")" << std::endl;
 
-        if (!processLocation(location, lat, lon)) {
-          std::cerr << "Failed to process location: " << location << std::endl;
-          return false;
+      if (!runLocation(loc.name, loc.lat, loc.lon)) {
+        if (!o3Cancelled()) {
+          emitError(loc.name, "processing failed");
+          std::cerr << "Failed to process location: " << loc.name
+                    << std::endl;
         }
+        ok = false;
+        break;
       }
     }
 
-    return true;
+    if (sources) {
+      sources->printSummary(std::cout);
+      sources.reset();
+    }
+    printExtractCache();
+    emitRunEnd(ok);
+    return ok;
   }
 
-  ~OptimizedOzoneDataProcessor() {
-    // Final cleanup only when processor is destroyed
-    std::vector<std::string> executables = {"aprobe.exe", "skim.exe",
-                                            "nmprobe.exe", "make_1995.exe"};
-    for (const auto &exe : executables) {
-      if (fs::exists(exe)) {
-        fs::remove(exe);
+  // Dry run: estimates what processLocationsParallel would read, spend and
+  // store for these locations without writing anything. The cost model is
+  // calibrated on the manifest's done records, or on one timed extraction
+  // in memory when there are none.
+  bool planLocations(const std::vector<O3Location> &allLocations,
+                     int numThreads = 0) {
+    std::vector<O3Location> shardLocations =
+        sharded ? o3ShardLocations(allLocations, shard) : allLocations;
+    o3PrioritizeLocations(shardLocations, focus.get(), priorityRanks.get());
+    std::vector<O3Location> locations;
+    for (const O3Location &loc : shardLocations) {
+      if (!isComplete(loc.name, loc.lat, loc.lon)) {
+        locations.push_back(loc);
       }
     }
+    if (sharded) {
+      std::cout << "Shard " << shard.index << "/" << shard.count << ": "
+                << shardLocations.size() << " of " << allLocations.size()
+                << " locations" << std::endl;
+    }
+    if (locations.size() < shardLocations.size()) {
+      std::cout << "Resuming: " << shardLocations.size() - locations.size()
+                << " locations already complete" << std::endl;
+    }
+    if ((focus || priorityRanks) && !locations.empty()) {
+      std::cout << "Order: " << locations.front().name << " first, "
+                << locations.back().name << " last" << std::endl;
+    }
+
+    if (numThreads == 0) {
+      numThreads =
+          std::min(static_cast<int>(std::thread::hardware_concurrency()), 8);
+    }
+    const int numIo = externalTools ? numThreads
+                                    : (ioWorkers > 0 ? ioWorkers : numThreads);
+    const int numCpu = cpuWorkers > 0 ? cpuWorkers : std::max(1, numIo / 2);
+
+    O3SourceFiles files[4];
+    o3ScanSources(pathO3Files, files);
+
+    double secondsPerUnit = 0;
+    const size_t history =
+        manifest ? o3CalibrateFromManifest(*manifest, secondsPerUnit) : 0;
+    if (history > 0) {
+      std::cout << "Calibrated on " << history << " finished locations"
+                << std::endl;
+    } else if (!locations.empty()) {
+      const O3Location &sample = locations[locations.size() / 2];
+      auto t0 = std::chrono::steady_clock::now();
+      O3LocationSeries series;
+      bool ok = o3ExtractOMI(pathO3Files, sample.lat, sample.lon, series);
+      for (int sat = 1; ok && sat <= 3; ++sat) {
+        ok = o3ExtractTOMS(pathO3Files, sample.lat, sample.lon,
+                           static_cast<O3TomsSatellite>(sat), series);
+      }
+      o3FillYear(1995, O3_PLACEHOLDER, series);
+      o3Skim(series);
+      if (!ok) {
+        std::cerr << "Sample extraction failed for " << sample.name
+                  << std::endl;
+        return false;
+      }
+      secondsPerUnit = secondsSince(t0) / o3LocationCost(sample.lat);
+      std::cout << "No run history in " << O3_MANIFEST_NAME
+                << "; calibrated on one extraction (" << sample.name << ")"
+                << std::endl;
+    }
+
+    std::cout << (externalTools ? "External tools, " : "In process, ")
+              << numIo << " extract and " << numCpu << " skim workers"
+              << std::endl;
+    const O3PlanEstimate est = o3EstimatePlan(
+        locations, files, secondsPerUnit, numIo, numCpu, !externalTools,
+        externalTools || yearFiles,
+        manifest ? o3AverageSkimBytes(*manifest) : 0);
+    o3PrintPlan(std::cout, est, files, externalTools);
+    return true;
   }
-};
 
-// Static member definitions
-std::mutex OptimizedOzoneDataProcessor::compilation_mutex;
-std::unordered_set<std::string> OptimizedOzoneDataProcessor::compiled_programs;
+  // Grid cells in the original order (longitude outer, latitude inner)
+  bool processGridParallel(const O3Grid &grid, int numThreads = 0) {
+    printGrid(grid);
+    return processLocationsParallel(o3GridLocations(grid), numThreads);
+  }
+
+  bool processGrid(const O3Grid &grid) {
+    printGrid(grid);
+    return processLocations(o3GridLocations(grid));
+  }
+
+  static void printGrid(const O3Grid &grid) {
+    const O3CellId last = static_cast<O3CellId>(grid.size()) - 1;
+    std::cout << "Grid: Lat[" << grid.latMin << "," << grid.latOf(last)
+              << "], Lon[" << grid.lonMin << "," << grid.lonOf(last)
+              << "], Precision: " << grid.step << std::endl;
+  }
+};
 
 void printUsage(const char *programName) {
   std::cout << "Usage for parallel grid processing:" << std::endl;
@@ -370,30 +1243,319 @@ void printUsage(const char *programName) {
                "<grid_precision> <cutoff_events>"
             << std::endl;
   std::cout << std::endl;
+  std::cout << "Usage for a list of points and polygons:" << std::endl;
+  std::cout << programName
+            << " points <path_to_ozone_data> <locations.csv> <cutoff_events> "
+               "[num_threads]"
+            << std::endl;
+  std::cout << std::endl;
   std::cout << "Usage for single location:" << std::endl;
   std::cout << programName
             << " location <location_name> <path_to_ozone_data> <lat> <lon> "
                "<cutoff_events>"
             << std::endl;
   std::cout << std::endl;
+  std::cout << "Usage for a dry run (estimates only, nothing is written):"
+            << std::endl;
+  std::cout << programName
+            << " plan <path_to_ozone_data> <lat_min> <lat_max> "
+               "<grid_precision> [num_threads]"
+            << std::endl;
+  std::cout << programName
+            << " plan <path_to_ozone_data> <locations.csv> [num_threads]"
+            << std::endl;
+  std::cout << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --external-tools  run aprobe/nmprobe/make_1995/skim as "
+               "separate executables"
+            << std::endl;
+  std::cout << "  --year-files      keep the yearly .dat files of <location>/ "
+               "(always written"
+            << std::endl;
+  std::cout << "                    with --external-tools)" << std::endl;
+  std::cout << "  --gaps=catalog    fill every day the data catalog lacks, "
+               "not only 1995"
+            << std::endl;
+  std::cout << "  --gap-fill=linear|climatology" << std::endl;
+  std::cout << "                    estimate the gap days (listed in "
+               "skim_<loc>/<loc>_filled.dat)"
+            << std::endl;
+  std::cout << "                    instead of writing the -2 placeholder"
+            << std::endl;
+  std::cout << "  --resume          skip locations " << O3_MANIFEST_NAME
+            << " lists as done" << std::endl;
+  std::cout << "  --lon=<min>,<max> longitude range of grid modes "
+               "(default -180,180)"
+            << std::endl;
+  std::cout << "  --io-threads=N    extraction workers (default: num_threads)"
+            << std::endl;
+  std::cout << "  --cpu-threads=N   skim workers (default: half the "
+               "extraction workers)"
+            << std::endl;
+  std::cout << "  --pin=cores|nodes pin each worker to a core, or to a NUMA "
+               "node, and split"
+            << std::endl;
+  std::cout << "                    the locations between the nodes (grid "
+               "and points modes)"
+            << std::endl;
+  std::cout << "  --shard i/N       process only shard i of N (grid and "
+               "points modes); merge"
+            << std::endl;
+  std::cout << "                    the shard directories with ozone_merge"
+            << std::endl;
+  std::cout << "  --fit=<alpha>     run chi2LRSO3vsSnRunApp on each finished "
+               "location; alpha"
+            << std::endl;
+  std::cout << "                    multiplies the error bars (-I)"
+            << std::endl;
+  std::cout << "  --fit-threads=N   fit workers (default: one per hardware "
+               "thread)"
+            << std::endl;
+  std::cout << "  --cache-dir=DIR   keep extracted source bins in DIR and "
+               "reuse them in later"
+            << std::endl;
+  std::cout << "                    runs until the data files change"
+            << std::endl;
+  std::cout << "  --events-fd=N     write JSON-lines progress events to open "
+               "descriptor N"
+            << std::endl;
+  std::cout << "  --focus=<lat>,<lon> or --focus=<latMin>,<latMax>,<lonMin>,"
+               "<lonMax>"
+            << std::endl;
+  std::cout << "                    process locations nearest the point or "
+               "box first"
+            << std::endl;
+  std::cout << "  --priority-file=F process the location names listed in F "
+               "first, in order"
+            << std::endl;
+  std::cout << std::endl;
+  std::cout << "Grid bounds and precision may be fractional. CSV lines are "
+               "'name,lat,lon' or"
+            << std::endl;
+  std::cout << "'name,polygon,<step>,<lat> <lon>,<lat> <lon>,...'; polygons "
+               "expand to the grid"
+            << std::endl;
+  std::cout << "cells inside them." << std::endl;
+  std::cout << std::endl;
   std::cout << "Examples:" << std::endl;
   std::cout << programName
             << " pgrid /path/to/nasa/data/ -90 90 10 6 4  # 4 threads"
             << std::endl;
+  std::cout << programName
+            << " pgrid /path/to/nasa/data/ -5 13 0.5 6 --lon=-80,-66"
+            << std::endl;
   std::cout << programName << " grid /path/to/nasa/data/ -90 90 10 6"
             << std::endl;
+  std::cout << programName << " points /path/to/nasa/data/ sites.csv 6 4"
+            << std::endl;
+  std::cout << programName
+            << " pgrid /path/to/nasa/data/ -90 90 10 7 --io-threads=16 "
+               "--cpu-threads=4 --fit=1.1"
+            << std::endl;
   std::cout << programName << " location BOG /path/to/nasa/data/ 4.36 -74.04 6"
             << std::endl;
+  std::cout << programName
+            << " plan /path/to/nasa/data/ -90 90 0.5 16 --resume" << std::endl;
+  std::cout << programName
+            << " pgrid /path/to/nasa/data/ -90 90 1 7 8 --fit=1.1 "
+               "--focus=-4.2,12.5,-79,-66.8"
+            << std::endl;
+}
+
+// Parses "--lon=<min>,<max>"
+static bool parseLonRange(const std::string &arg, double &lonMin,
+                          double &lonMax) {
+  double lo, hi;
+  char tail;
+  if (std::sscanf(arg.c_str(), "--lon=%lf,%lf%c", &lo, &hi, &tail) != 2 ||
+      lo > hi || lo < -180 || hi > 180) {
+    return false;
+  }
+  lonMin = lo;
+  lonMax = hi;
+  return true;
+}
+
+// Parses "--<name>=<positive count>"
+static bool parseCount(const std::string &arg, int &count) {
+  const int n = std::atoi(arg.c_str() + arg.find('=') + 1);
+  if (n <= 0) {
+    std::cerr << "Invalid thread count: " << arg << std::endl;
+    return false;
+  }
+  count = n;
+  return true;
+}
+
+// Exit status of a run that did not complete; 130 (as for SIGINT) if it was
+// cancelled, finished locations are kept either way
+static int runFailed(const char *message) {
+  if (o3Cancelled()) {
+    std::cerr << "Run cancelled; rerun with --resume to continue" << std::endl;
+    return 130;
+  }
+  std::cerr << message << std::endl;
+  return 1;
 }
 
 int main(int argc, char *argv[]) {
+  // Options may appear anywhere; the remaining arguments are positional
+  bool externalTools = false;
+  bool resume = false;
+  bool yearFiles = false;
+  bool catalogGaps = false;
+  O3GapFill gapFill = O3GapFill::Marker;
+  double lonMin = -180;
+  double lonMax = 180;
+  int ioThreads = 0;
+  int cpuThreads = 0;
+  int fitThreads = 0;
+  bool fit = false;
+  double fitAlpha = 0;
+  bool sharded = false;
+  O3Shard shard;
+  int eventsFd = -1;
+  bool focused = false;
+  O3Focus focus;
+  std::string priorityFile;
+  O3PinMode pinMode = O3PinMode::None;
+  std::string cacheDir;
+  int nArgs = 0;
+  for (int i = 0; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--external-tools") {
+      externalTools = true;
+    } else if (arg == "--resume") {
+      resume = true;
+    } else if (arg == "--year-files") {
+      yearFiles = true;
+    } else if (arg == "--gaps=catalog" || arg == "--gaps=1995") {
+      catalogGaps = arg == "--gaps=catalog";
+    } else if (arg.rfind("--gap-fill=", 0) == 0) {
+      if (!o3ParseGapFill(arg.substr(11), gapFill)) {
+        std::cerr << "Invalid gap fill (expected marker, linear or "
+                     "climatology): "
+                  << arg << std::endl;
+        return 1;
+      }
+    } else if (arg.rfind("--lon=", 0) == 0) {
+      if (!parseLonRange(arg, lonMin, lonMax)) {
+        std::cerr << "Invalid longitude range: " << arg << std::endl;
+        return 1;
+      }
+    } else if (arg.rfind("--io-threads=", 0) == 0) {
+      if (!parseCount(arg, ioThreads)) {
+        return 1;
+      }
+    } else if (arg.rfind("--cpu-threads=", 0) == 0) {
+      if (!parseCount(arg, cpuThreads)) {
+        return 1;
+      }
+    } else if (arg.rfind("--fit-threads=", 0) == 0) {
+      if (!parseCount(arg, fitThreads)) {
+        return 1;
+      }
+    } else if (arg.rfind("--pin=", 0) == 0) {
+      if (!o3ParsePinMode(arg.substr(6), pinMode)) {
+        std::cerr << "Invalid pinning (expected cores, nodes or none): "
+                  << arg << std::endl;
+        return 1;
+      }
+    } else if (arg == "--shard" || arg.rfind("--shard=", 0) == 0) {
+      // "--shard i/N" or "--shard=i/N"
+      std::string value = arg.size() > 7 ? arg.substr(8) : "";
+      if (arg.size() == 7 && i + 1 < argc) {
+        value = argv[++i];
+      }
+      if (!o3ParseShard(value, shard)) {
+        std::cerr << "Invalid shard (expected i/N, 1 <= i <= N): " << value
+                  << std::endl;
+        return 1;
+      }
+      sharded = true;
+    } else if (arg.rfind("--focus=", 0) == 0) {
+      if (!o3ParseFocus(arg.substr(8), focus)) {
+        std::cerr << "Invalid focus (expected lat,lon or "
+                     "latMin,latMax,lonMin,lonMax): "
+                  << arg << std::endl;
+        return 1;
+      }
+      focused = true;
+    } else if (arg.rfind("--priority-file=", 0) == 0) {
+      priorityFile = arg.substr(16);
+    } else if (arg.rfind("--cache-dir=", 0) == 0) {
+      cacheDir = arg.substr(12);
+    } else if (arg.rfind("--events-fd=", 0) == 0) {
+      char *end;
+      const long fd = std::strtol(arg.c_str() + 12, &end, 10);
+      if (*end != '\0' || end == arg.c_str() + 12 || fd < 0 || fd > INT_MAX) {
+        std::cerr << "Invalid events descriptor: " << arg << std::endl;
+        return 1;
+      }
+      eventsFd = static_cast<int>(fd);
+    } else if (arg.rfind("--fit=", 0) == 0) {
+      char *end;
+      fitAlpha = std::strtod(arg.c_str() + 6, &end);
+      if (*end != '\0' || end == arg.c_str() + 6 || !(fitAlpha > 0) ||
+          !std::isfinite(fitAlpha)) {
+        std::cerr << "Invalid fit error-bar multiplier (expected alpha > 0): "
+                  << arg << std::endl;
+        return 1;
+      }
+      fit = true;
+    } else {
+      argv[nArgs++] = argv[i];
+    }
+  }
+  argc = nArgs;
+
   if (argc < 2) {
     printUsage(argv[0]);
     return 1;
   }
 
+  // dryRun (plan mode): creates no manifest or cache directory, and reads
+  // an existing manifest for past timings only
+  auto configure = [&](OptimizedOzoneDataProcessor &processor,
+                       bool dryRun = false) {
+    processor.setExternalTools(externalTools);
+    processor.setYearFiles(yearFiles);
+    processor.setStageWorkers(ioThreads, cpuThreads);
+    processor.setPlacement(pinMode);
+    if (!processor.setGapFill(gapFill, catalogGaps)) {
+      return false;
+    }
+    if (sharded) {
+      processor.setShard(shard);
+    }
+    if (eventsFd >= 0 && !processor.setEventsFd(eventsFd)) {
+      return false;
+    }
+    if (focused) {
+      processor.setFocus(focus);
+    }
+    if (!priorityFile.empty() && !processor.setPriorityFile(priorityFile)) {
+      return false;
+    }
+    if (!cacheDir.empty() && (!dryRun || fs::is_directory(cacheDir)) &&
+        !processor.setExtractCache(cacheDir)) {
+      return false;
+    }
+    if (fit && !processor.enableFit(fitAlpha, fitThreads)) {
+      return false;
+    }
+    if (dryRun && !fs::exists(O3_MANIFEST_NAME)) {
+      return true;
+    }
+    return processor.openManifest(O3_MANIFEST_NAME, resume);
+  };
+
   std::string mode = argv[1];
 
+  // SIGINT/SIGTERM: finish or roll back the locations in flight, start no
+  // new ones; a second signal exits at once
+  o3InstallCancelHandlers();
+
   if (mode == "pgrid") { // Parallel grid processing
     if (argc < 7 || argc > 8) {
       std::cout << "Parallel grid mode requires 6-7 arguments" << std::endl;
@@ -402,26 +1564,29 @@ int main(int argc, char *argv[]) {
     }
 
     std::string pathO3Files = argv[2];
-    int latMin = std::stoi(argv[3]);
-    int latMax = std::stoi(argv[4]);
-    int gridPrecision = std::stoi(argv[5]);
+    double latMin = std::stod(argv[3]);
+    double latMax = std::stod(argv[4]);
+    double gridPrecision = std::stod(argv[5]);
     int evCut = std::stoi(argv[6]);
     int numThreads = (argc == 8) ? std::stoi(argv[7]) : 0;
 
-    // Fixed longitude range
-    int lonMin = -180;
-    int lonMax = 180;
+    if (gridPrecision <= 0 || latMin > latMax) {
+      std::cerr << "Invalid grid bounds or precision" << std::endl;
+      return 1;
+    }
 
     auto start = std::chrono::high_resolution_clock::now();
 
     OptimizedOzoneDataProcessor processor(pathO3Files, evCut);
-
-    if (!processor.processGridParallel(latMin, latMax, lonMin, lonMax,
-                                       gridPrecision, numThreads)) {
-      std::cerr << "Parallel grid processing failed" << std::endl;
+    if (!configure(processor)) {
       return 1;
     }
 
+    const O3Grid grid(latMin, latMax, lonMin, lonMax, gridPrecision);
+    if (!processor.processGridParallel(grid, numThreads)) {
+      return runFailed("Parallel grid processing failed");
+    }
+
     auto end = std::chrono::high_resolution_clock::now();
     auto duration =
         std::chrono::duration_cast<std::chrono::seconds>(end - start);
@@ -437,23 +1602,28 @@ int main(int argc, char *argv[]) {
     }
 
     std::string pathO3Files = argv[2];
-    int latMin = std::stoi(argv[3]);
-    int latMax = std::stoi(argv[4]);
-    int gridPrecision = std::stoi(argv[5]);
+    double latMin = std::stod(argv[3]);
+    double latMax = std::stod(argv[4]);
+    double gridPrecision = std::stod(argv[5]);
     int evCut = std::stoi(argv[6]);
 
-    int lonMin = -180;
-    int lonMax = 180;
+    if (gridPrecision <= 0 || latMin > latMax) {
+      std::cerr << "Invalid grid bounds or precision" << std::endl;
+      return 1;
+    }
 
     auto start = std::chrono::high_resolution_clock::now();
 
     OptimizedOzoneDataProcessor processor(pathO3Files, evCut);
-
-    if (!processor.processGrid(latMin, latMax, lonMin, lonMax, gridPrecision)) {
-      std::cerr << "Grid processing failed" << std::endl;
+    if (!configure(processor)) {
       return 1;
     }
 
+    const O3Grid grid(latMin, latMax, lonMin, lonMax, gridPrecision);
+    if (!processor.processGrid(grid)) {
+      return runFailed("Grid processing failed");
+    }
+
     auto end = std::chrono::high_resolution_clock::now();
     auto duration =
         std::chrono::duration_cast<std::chrono::seconds>(end - start);
@@ -461,7 +1631,92 @@ int main(int argc, char *argv[]) {
     std::cout << "Grid processing completed successfully in "
               << duration.count() << " seconds" << std::endl;
 
+  } else if (mode == "points") { // Named points and polygons from a CSV
+    if (argc < 5 || argc > 6) {
+      std::cout << "Points mode requires 4-5 arguments" << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    std::string pathO3Files = argv[2];
+    std::string csvPath = argv[3];
+    int evCut = std::stoi(argv[4]);
+    int numThreads = (argc == 6) ? std::stoi(argv[5]) : 0;
+
+    std::vector<O3Location> locations;
+    std::string error;
+    if (!o3ReadLocationsCsv(csvPath, locations, error)) {
+      std::cerr << error << std::endl;
+      return 1;
+    }
+    if (locations.empty()) {
+      std::cerr << "No locations in " << csvPath << std::endl;
+      return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    OptimizedOzoneDataProcessor processor(pathO3Files, evCut);
+    if (!configure(processor)) {
+      return 1;
+    }
+
+    if (!processor.processLocationsParallel(locations, numThreads)) {
+      return runFailed("Points processing failed");
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration =
+        std::chrono::duration_cast<std::chrono::seconds>(end - start);
+
+    std::cout << "Points processing completed successfully in "
+              << duration.count() << " seconds" << std::endl;
+
+  } else if (mode == "plan") { // Dry run of a grid or points run
+    if (argc < 4 || argc > 7) {
+      std::cout << "Plan mode requires 2-5 arguments" << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    std::string pathO3Files = argv[2];
+    std::vector<O3Location> locations;
+    int numThreads = 0;
+    if (argc >= 6) {
+      double latMin = std::stod(argv[3]);
+      double latMax = std::stod(argv[4]);
+      double gridPrecision = std::stod(argv[5]);
+      numThreads = (argc == 7) ? std::stoi(argv[6]) : 0;
+      if (gridPrecision <= 0 || latMin > latMax) {
+        std::cerr << "Invalid grid bounds or precision" << std::endl;
+        return 1;
+      }
+      const O3Grid grid(latMin, latMax, lonMin, lonMax, gridPrecision);
+      OptimizedOzoneDataProcessor::printGrid(grid);
+      locations = o3GridLocations(grid);
+    } else {
+      std::string error;
+      if (!o3ReadLocationsCsv(argv[3], locations, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+      numThreads = (argc == 5) ? std::stoi(argv[4]) : 0;
+    }
+
+    OptimizedOzoneDataProcessor processor(pathO3Files, 0);
+    if (!configure(processor, true)) {
+      return 1;
+    }
+
+    if (!processor.planLocations(locations, numThreads)) {
+      return 1;
+    }
+
   } else if (mode == "location") {
+    if (sharded) {
+      std::cerr << "--shard applies to the grid and points modes" << std::endl;
+      return 1;
+    }
     if (argc != 7) {
       std::cout << "Location mode requires 6 arguments" << std::endl;
       printUsage(argv[0]);
@@ -469,18 +1724,31 @@ int main(int argc, char *argv[]) {
     }
 
     std::string location = argv[2];
+    if (!o3ValidLocationName(location)) {
+      std::cerr << "Invalid location name (letters, digits, '_', '.' and '-' "
+                   "only): "
+                << location << std::endl;
+      return 1;
+    }
     std::string pathO3Files = argv[3];
     double lat = std::stod(argv[4]);
     double lon = std::stod(argv[5]);
     int evCut = std::stoi(argv[6]);
 
     OptimizedOzoneDataProcessor processor(pathO3Files, evCut);
-
-    if (!processor.processLocation(location, lat, lon)) {
-      std::cerr << "Location processing failed" << std::endl;
+    if (!configure(processor)) {
       return 1;
     }
 
+    if (processor.isComplete(location, lat, lon)) {
+      std::cout << "Location already complete: " << location << std::endl;
+      return 0;
+    }
+
+    if (!processor.runSingleLocation(location, lat, lon)) {
+      return runFailed("Location processing failed");
+    }
+
     std::cout << "Location processing completed successfully" << std::endl;
   } else {
     std::cout << "Unknown mode: " << mode << std::endl;
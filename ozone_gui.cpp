@@ -1,4 +1,5 @@
 #include "viewO3Global.cpp" // <--- Add this line
+#include "include/o3Grid.h"
 #include <TApplication.h>
 #include <TCanvas.h>
 #include <TFile.h>
@@ -24,11 +25,11 @@
 #include <TImage.h>
 #include <TKey.h>
 #include <TList.h>
-#include <TRegexp.h>
 #include <TRootEmbeddedCanvas.h>
 #include <TSystem.h>
 #include <TTimer.h>
 #include <chrono>
+#include <cstdlib>
 #include <ctime>
 #include <dirent.h>
 #include <fcntl.h>
@@ -45,27 +46,34 @@ private:
   // Original UI elements
   TGComboBox *fModeSelector;
   TGTextEntry *fDataPathEntry;
-  TGTextEntry *fLocationEntry;
-  TGDoubleHSlider *fLatSlider;
-  TGLabel *fLatMinLabel, *fLatMaxLabel;
+  TGTextEntry *fLocationEntry, *fPointsEntry;
+  TGNumberEntry *fLocLat, *fLocLon;
+  TGDoubleHSlider *fLatSlider, *fLonSlider;
+  TGLabel *fLatMinLabel, *fLatMaxLabel, *fLonMinLabel, *fLonMaxLabel;
   TGNumberEntry *fParamGrid, *fParamEvents, *fParamThreads;
   TGTextView *fLogView;
   TGTextButton *fSilentModeButton;
   TGTextButton *fNotificationButton;
+  TGTextButton *fResumeButton;
   TString fExePath;
 
   // Process control
   TGTextButton *fRunButton, *fCancelButton;
   pid_t fProcessPid;
   int fPipeFd[2];
+  int fEventsFd[2];         // processor --events-fd=3 (JSON lines)
+  std::string fEventsLine;  // partial event line
+  TGLabel *fProgressLabel;
   TTimer *fOutputTimer;
   Bool_t fProcessRunning;
   Bool_t fCompletionHandled;
   Bool_t fSilentMode;
   Bool_t fNotificationsEnabled;
+  Bool_t fResumeEnabled;
   std::chrono::time_point<std::chrono::steady_clock> fProcessStartTime;
   std::vector<std::string> fOutputBuffer;
   static const int kMaxBufferSize = 50;
+  static const int kCancelWaitTicks = 300; // 100 ms each
 
   // New graph viewer elements
   TGTab *fMainTabs;
@@ -111,7 +119,8 @@ public:
   OzoneGUI(const TGWindow *p, UInt_t w, UInt_t h)
       : TGMainFrame(p, w, h), fProcessPid(-1), fOutputTimer(nullptr),
         fProcessRunning(kFALSE), fCompletionHandled(kFALSE), fSilentMode(kFALSE),
-        fNotificationsEnabled(kTRUE), fCurrentFile(nullptr), fMacroPid(-1),
+        fNotificationsEnabled(kTRUE), fResumeEnabled(kTRUE),
+        fCurrentFile(nullptr), fMacroPid(-1),
         fMacroTimer(nullptr), fMacroRunning(kFALSE), fMacroCompletionHandled(kFALSE),
         fMacroPipeFd(-1),
         fParam1Frame(nullptr), fParam2Frame(nullptr), fParam3Frame(nullptr),
@@ -121,6 +130,7 @@ public:
 
     // Initialize pipe
     fPipeFd[0] = fPipeFd[1] = -1;
+    fEventsFd[0] = fEventsFd[1] = -1;
 
     // Create main tab widget
     fMainTabs = new TGTab(this, 600, 800);
@@ -185,6 +195,7 @@ public:
     MapWindow();
 
     UpdateLatLabels();
+    UpdateLonLabels();
 
     // Initialize graph viewer with current directory
     fGraphPathEntry->SetText(gSystem->WorkingDirectory());
@@ -394,6 +405,7 @@ public:
     fModeSelector = new TGComboBox(modeHFrame);
     fModeSelector->AddEntry("pgrid", 1);
     fModeSelector->AddEntry("location", 2);
+    fModeSelector->AddEntry("points", 3);
     fModeSelector->Select(2);
     fModeSelector->Resize(200, 28);
     modeHFrame->AddFrame(
@@ -406,7 +418,7 @@ public:
                                                   10, 10, 10, 5));
 
     TGGroupFrame *locFrame =
-        new TGGroupFrame(parent, "Location (only for 'location' mode)");
+        new TGGroupFrame(parent, "Location ('location' and 'points' modes)");
     TGHorizontalFrame *locHFrame = new TGHorizontalFrame(locFrame);
     locHFrame->AddFrame(
         new TGLabel(locHFrame, "Code:"),
@@ -418,8 +430,44 @@ public:
         fLocationEntry,
         new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
 
+    locHFrame->AddFrame(
+        new TGLabel(locHFrame, "Lat:"),
+        new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
+    fLocLat = new TGNumberEntry(locHFrame, 4.36, 8, -1,
+                                TGNumberFormat::kNESRealTwo,
+                                TGNumberFormat::kNEAAnyNumber,
+                                TGNumberFormat::kNELLimitMinMax, -90, 90);
+    fLocLat->Resize(90, 28);
+    locHFrame->AddFrame(
+        fLocLat, new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
+
+    locHFrame->AddFrame(
+        new TGLabel(locHFrame, "Lon:"),
+        new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
+    fLocLon = new TGNumberEntry(locHFrame, -74.04, 8, -1,
+                                TGNumberFormat::kNESRealTwo,
+                                TGNumberFormat::kNEAAnyNumber,
+                                TGNumberFormat::kNELLimitMinMax, -180, 180);
+    fLocLon->Resize(90, 28);
+    locHFrame->AddFrame(
+        fLocLon, new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
+
     locFrame->AddFrame(locHFrame,
                        new TGLayoutHints(kLHintsExpandX, 5, 5, 5, 5));
+
+    // CSV of named points and polygons for 'points' mode
+    TGHorizontalFrame *pointsHFrame = new TGHorizontalFrame(locFrame);
+    pointsHFrame->AddFrame(
+        new TGLabel(pointsHFrame, "Points CSV:"),
+        new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 5, 5));
+    fPointsEntry = new TGTextEntry(pointsHFrame, new TGTextBuffer(200));
+    fPointsEntry->SetText("sites.csv");
+    fPointsEntry->Resize(300, 28);
+    pointsHFrame->AddFrame(
+        fPointsEntry,
+        new TGLayoutHints(kLHintsExpandX | kLHintsCenterY, 5, 5, 5, 5));
+    locFrame->AddFrame(pointsHFrame,
+                       new TGLayoutHints(kLHintsExpandX, 5, 5, 0, 5));
     parent->AddFrame(locFrame, new TGLayoutHints(kLHintsExpandX, 10, 10, 5, 5));
 
     // -------- Data Path Section --------
@@ -465,6 +513,27 @@ public:
                        new TGLayoutHints(kLHintsExpandX, 10, 10, 0, 10));
     parent->AddFrame(latFrame, new TGLayoutHints(kLHintsExpandX, 10, 10, 5, 5));
 
+    // -------- Longitude Section --------
+    TGGroupFrame *lonFrame = new TGGroupFrame(parent, "Longitude Range");
+    fLonSlider =
+        new TGDoubleHSlider(lonFrame, 200, kDoubleScaleBoth, -1,
+                            kHorizontalFrame, GetDefaultFrameBackground());
+    fLonSlider->SetRange(-180, 180);
+    fLonSlider->SetPosition(-180, 180);
+    fLonSlider->Connect("PositionChanged()", "OzoneGUI", this,
+                        "UpdateLonLabels()");
+    lonFrame->AddFrame(fLonSlider,
+                       new TGLayoutHints(kLHintsExpandX, 10, 10, 5, 5));
+
+    TGHorizontalFrame *lonLabelFrame = new TGHorizontalFrame(lonFrame);
+    fLonMinLabel = new TGLabel(lonLabelFrame, "Min: -180");
+    fLonMaxLabel = new TGLabel(lonLabelFrame, "Max: 180");
+    lonLabelFrame->AddFrame(fLonMinLabel, new TGLayoutHints(kLHintsLeft));
+    lonLabelFrame->AddFrame(fLonMaxLabel, new TGLayoutHints(kLHintsRight));
+    lonFrame->AddFrame(lonLabelFrame,
+                       new TGLayoutHints(kLHintsExpandX, 10, 10, 0, 10));
+    parent->AddFrame(lonFrame, new TGLayoutHints(kLHintsExpandX, 10, 10, 5, 5));
+
     // -------- Parameters Section --------
     TGGroupFrame *paramFrame = new TGGroupFrame(parent, "Parameters");
     TGCompositeFrame *paramMatrix =
@@ -475,9 +544,9 @@ public:
         new TGLabel(paramMatrix, "Grid:"),
         new TGLayoutHints(kLHintsRight | kLHintsCenterY, 5, 5, 2, 2));
     fParamGrid =
-        new TGNumberEntry(paramMatrix, 10, 6, -1, TGNumberFormat::kNESInteger,
-                          TGNumberFormat::kNEANonNegative,
-                          TGNumberFormat::kNELLimitMinMax, 0, 100);
+        new TGNumberEntry(paramMatrix, 10, 6, -1, TGNumberFormat::kNESRealTwo,
+                          TGNumberFormat::kNEAPositive,
+                          TGNumberFormat::kNELLimitMinMax, 0.01, 100);
     fParamGrid->Resize(80, 28);
     paramMatrix->AddFrame(
         fParamGrid,
@@ -529,6 +598,12 @@ public:
     perfHFrame->AddFrame(fNotificationButton,
                          new TGLayoutHints(kLHintsLeft, 5, 5, 5, 5));
 
+    fResumeButton = new TGTextButton(perfHFrame, "Resume: ON");
+    fResumeButton->Connect("Clicked()", "OzoneGUI", this, "ToggleResume()");
+    fResumeButton->Resize(150, 28);
+    perfHFrame->AddFrame(fResumeButton,
+                         new TGLayoutHints(kLHintsLeft, 5, 5, 5, 5));
+
     perfFrame->AddFrame(perfHFrame, new TGLayoutHints(kLHintsLeft, 5, 5, 5, 5));
     parent->AddFrame(perfFrame,
                      new TGLayoutHints(kLHintsExpandX, 10, 10, 5, 5));
@@ -549,6 +624,11 @@ public:
     btnFrame->AddFrame(fCancelButton,
                        new TGLayoutHints(kLHintsCenterX, 5, 5, 10, 10));
 
+    fProgressLabel = new TGLabel(btnFrame, "Idle");
+    btnFrame->AddFrame(fProgressLabel, new TGLayoutHints(
+                                           kLHintsCenterY | kLHintsLeft, 15,
+                                           5, 10, 10));
+
     parent->AddFrame(btnFrame, new TGLayoutHints(kLHintsCenterX));
 
     // -------- Log Output --------
@@ -1205,20 +1285,10 @@ public:
 
     // Extract lat/lon info from folder name
     TString info = "Selected: " + selectedFolder;
-    TRegexp latPattern("LAT-?[0-9]+");
-    TRegexp lonPattern("LON-?[0-9]+");
-
-    Ssiz_t latStart, latLen, lonStart, lonLen;
-    if (selectedFolder.Index(latPattern, &latLen, latStart) != -1) {
-      TString latPart = selectedFolder(latStart, latLen);
-      latPart.ReplaceAll("LAT", "");
-      info += " (Lat: " + latPart + "°";
-
-      if (selectedFolder.Index(lonPattern, &lonLen, lonStart) != -1) {
-        TString lonPart = selectedFolder(lonStart, lonLen);
-        lonPart.ReplaceAll("LON", "");
-        info += ", Lon: " + lonPart + "°)";
-      }
+    double lat, lon;
+    if (o3ParseCellName(selectedFolder.Data(), lat, lon)) {
+      info += " (Lat: " + TString(O3Grid::formatCoord(lat)) + "°, Lon: " +
+              TString(O3Grid::formatCoord(lon)) + "°)";
     }
 
     fGraphInfoLabel->SetText(info.Data());
@@ -1504,6 +1574,14 @@ public:
     Layout();
   }
 
+  void UpdateLonLabels() {
+    double lonMin = fLonSlider->GetMinPosition();
+    double lonMax = fLonSlider->GetMaxPosition();
+    fLonMinLabel->SetText(Form("Min: %.0f", lonMin));
+    fLonMaxLabel->SetText(Form("Max: %.0f", lonMax));
+    Layout();
+  }
+
   void AppendLog(const char *msg) {
     if (fSilentMode && fProcessRunning) {
       return;
@@ -1546,6 +1624,18 @@ public:
     }
   }
 
+  void ToggleResume() {
+    fResumeEnabled = !fResumeEnabled;
+    if (fResumeEnabled) {
+      fResumeButton->SetText("Resume: ON");
+      AppendLog("Resume enabled - locations finished by earlier (or "
+                "cancelled) runs are skipped.");
+    } else {
+      fResumeButton->SetText("Resume: OFF");
+      AppendLog("Resume disabled - every location is processed again.");
+    }
+  }
+
   void ShowCompletionNotification(int exitCode, const std::string &duration) {
     if (!fNotificationsEnabled)
       return;
@@ -1612,6 +1702,16 @@ public:
     }
   }
 
+  void CloseEventsPipe() {
+    for (int &fd : fEventsFd) {
+      if (fd != -1) {
+        close(fd);
+        fd = -1;
+      }
+    }
+    fEventsLine.clear();
+  }
+
   void CleanupProcess() {
     if (fPipeFd[0] != -1) {
       close(fPipeFd[0]);
@@ -1621,10 +1721,48 @@ public:
       close(fPipeFd[1]);
       fPipeFd[1] = -1;
     }
+    CloseEventsPipe();
     fProcessPid = -1;
     fProcessRunning = kFALSE;
   }
 
+  // Numeric field of a JSON event line ("key":value); fallback if absent
+  static double EventNumber(const std::string &line, const char *key,
+                            double fallback = 0) {
+    const std::string tag = std::string("\"") + key + "\":";
+    const size_t pos = line.find(tag);
+    if (pos == std::string::npos)
+      return fallback;
+    return std::strtod(line.c_str() + pos + tag.size(), nullptr);
+  }
+
+  // Reads the processor's progress events; works in silent mode too
+  void ReadProcessEvents() {
+    if (fEventsFd[0] == -1)
+      return;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fEventsFd[0], buffer, sizeof(buffer))) > 0) {
+      fEventsLine.append(buffer, n);
+      size_t end;
+      while ((end = fEventsLine.find('\n')) != std::string::npos) {
+        const std::string line = fEventsLine.substr(0, end);
+        fEventsLine.erase(0, end + 1);
+        if (line.find("\"event\":\"progress\"") == std::string::npos)
+          continue;
+        const int done = (int)EventNumber(line, "done");
+        const int total = (int)EventNumber(line, "total");
+        const int failed = (int)EventNumber(line, "failed");
+        const double eta = EventNumber(line, "eta");
+        fProgressLabel->SetText(
+            Form("%d/%d locations (%d failed), %.1f/s, ETA %s", done, total,
+                 failed, EventNumber(line, "rate"),
+                 FormatDuration(std::chrono::seconds((long)eta)).c_str()));
+        Layout();
+      }
+    }
+  }
+
   void RunProcessor() {
     if (fExePath.IsNull()) {
       AppendLog("Error: processor executable not found.");
@@ -1644,6 +1782,11 @@ public:
         return;
       }
     }
+    if (pipe(fEventsFd) == -1) {
+      AppendLog("Error: failed to create events pipe.");
+      CleanupProcess();
+      return;
+    }
 
     TString oldDir = gSystem->WorkingDirectory();
     TString exeDir = gSystem->DirName(fExePath);
@@ -1653,6 +1796,8 @@ public:
 
     double latMin = fLatSlider->GetMinPosition();
     double latMax = fLatSlider->GetMaxPosition();
+    double lonMin = fLonSlider->GetMinPosition();
+    double lonMax = fLonSlider->GetMaxPosition();
 
     std::string cmd;
     if (mode == "location") {
@@ -1660,17 +1805,31 @@ public:
       cmd = std::string(fExePath.Data()) + " location " +
             std::string(locCode.Data()) + " " +
             std::string(fDataPathEntry->GetText()) + " " +
-            std::to_string(4.36) + " " + std::to_string(-74.04) + " " +
-            std::to_string((int)fParamGrid->GetNumber());
+            Form("%g %g ", fLocLat->GetNumber(), fLocLon->GetNumber()) +
+            std::to_string((int)fParamEvents->GetNumber());
+    } else if (mode == "points") {
+      cmd = std::string(fExePath.Data()) + " points " +
+            std::string(fDataPathEntry->GetText()) + " " +
+            std::string(fPointsEntry->GetText()) + " " +
+            std::to_string((int)fParamEvents->GetNumber()) + " " +
+            std::to_string((int)fParamThreads->GetNumber());
     } else {
       cmd = std::string(fExePath.Data()) + " " + std::string(mode.Data()) +
             " " + std::string(fDataPathEntry->GetText()) + " " +
-            std::to_string((int)latMin) + " " + std::to_string((int)latMax) +
-            " " + std::to_string((int)fParamGrid->GetNumber()) + " " +
+            Form("%.0f %.0f %g ", latMin, latMax, fParamGrid->GetNumber()) +
             std::to_string((int)fParamEvents->GetNumber()) + " " +
-            std::to_string((int)fParamThreads->GetNumber());
+            std::to_string((int)fParamThreads->GetNumber()) +
+            Form(" --lon=%.0f,%.0f", lonMin, lonMax);
     }
 
+    // Progress comes as JSON lines on descriptor 3, not from the log text
+    cmd += " --events-fd=3";
+    if (fResumeEnabled) {
+      cmd += " --resume";
+    }
+    fProgressLabel->SetText("Starting...");
+    Layout();
+
     AppendLog(Form("Running: %s", cmd.c_str()));
     if (fSilentMode) {
       AppendLog("Running in silent mode - please wait for completion...");
@@ -1696,12 +1855,23 @@ public:
         dup2(fPipeFd[1], STDERR_FILENO);
         close(fPipeFd[1]);
       }
+      close(fEventsFd[0]);
+      if (fEventsFd[1] != 3) {
+        dup2(fEventsFd[1], 3);
+        close(fEventsFd[1]);
+      }
 
       chdir(exeDir.Data());
-      execl("/bin/sh", "sh", "-c", cmd.c_str(), (char *)nullptr);
+      // exec: the shell is replaced, so fProcessPid is the processor itself
+      const std::string execCmd = "exec " + cmd;
+      execl("/bin/sh", "sh", "-c", execCmd.c_str(), (char *)nullptr);
       exit(1);
     }
 
+    close(fEventsFd[1]);
+    fEventsFd[1] = -1;
+    fcntl(fEventsFd[0], F_SETFL, fcntl(fEventsFd[0], F_GETFL, 0) | O_NONBLOCK);
+
     if (!fSilentMode) {
       close(fPipeFd[1]);
       fPipeFd[1] = -1;
@@ -1757,6 +1927,7 @@ public:
         }
       }
     }
+    ReadProcessEvents();
 
     int status;
     pid_t result = waitpid(fProcessPid, &status, WNOHANG);
@@ -1797,6 +1968,8 @@ public:
       }
 
       // Cleanup pipes and process state
+      ReadProcessEvents();
+      CloseEventsPipe();
       if (fPipeFd[0] != -1) {
         close(fPipeFd[0]);
         fPipeFd[0] = -1;
@@ -1831,27 +2004,32 @@ public:
       fOutputTimer->Stop();
     }
 
-    AppendLog(Form("Cancelling process group (PID: %d)...", fProcessPid));
+    AppendLog(Form("Cancelling processor (PID: %d)...", fProcessPid));
 
-    // Kill the entire process group (negative PID) to ensure child processes are also terminated
-    if (kill(-fProcessPid, SIGTERM) == 0) {
-      AppendLog("Sent SIGTERM to process group, waiting for processes to terminate...");
+    // SIGTERM to the processor only: it starts no new locations, lets the
+    // stage executables in flight finish, rolls back unfinished locations
+    // and records the finished ones for --resume
+    if (kill(fProcessPid, SIGTERM) == 0) {
+      AppendLog("Sent SIGTERM, waiting for in-flight locations to finish...");
 
-      for (int i = 0; i < 30; i++) {
+      for (int i = 0; i < kCancelWaitTicks; i++) {
         int status;
         pid_t result = waitpid(fProcessPid, &status, WNOHANG);
         if (result == fProcessPid) {
-          AppendLog("Process group terminated gracefully.");
+          ReadProcessEvents();
+          AppendLog("Processor stopped; finished locations are kept and "
+                    "skipped by the next run while Resume is ON.");
           CleanupProcess();
           fRunButton->SetEnabled(kTRUE);
           fCancelButton->SetEnabled(kFALSE);
           return;
         }
+        ReadProcessEvents();
         gSystem->Sleep(100);
         gSystem->ProcessEvents();
       }
 
-      AppendLog("Process group didn't terminate gracefully, using SIGKILL...");
+      AppendLog("Processor didn't stop in time, using SIGKILL...");
       if (kill(-fProcessPid, SIGKILL) == 0) {
         waitpid(fProcessPid, nullptr, 0);
         AppendLog("Process group killed successfully.");
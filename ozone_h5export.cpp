@@ -0,0 +1,493 @@
+// ozone_h5export.cpp
+// Exports a processed grid (daily store, monthly/annual rollups and linear
+// fit results) into one chunked, deflate-compressed HDF5 file with CF-style
+// dimension scales.
+//
+// Chunks are compressed with zlib by worker threads and handed to HDF5 with
+// H5Dwrite_chunk, so the (single threaded) HDF5 library only does the I/O.
+//
+// Build: h5c++ -O3 -std=c++17 ozone_h5export.cpp -o ozone_h5export
+//        -lhdf5_hl -lz -pthread
+#include "include/o3Store.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <hdf5.h>
+#include <hdf5_hl.h>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+
+// Element types of the datasets: values (float, O3_MISSING where unset) and
+// fill flags (uint8, 0 where unset)
+template <class T> struct H5Element;
+
+template <> struct H5Element<float> {
+  static constexpr float fill = O3_MISSING;
+  static hid_t memType() { return H5T_NATIVE_FLOAT; }
+  static hid_t fileType() { return H5T_IEEE_F32LE; }
+};
+
+template <> struct H5Element<uint8_t> {
+  static constexpr uint8_t fill = 0;
+  static hid_t memType() { return H5T_NATIVE_UINT8; }
+  static hid_t fileType() { return H5T_STD_U8LE; }
+};
+
+class OzoneH5Exporter {
+private:
+  const O3Store &store;
+  hid_t file = -1;
+  int numThreads;
+  int level;
+
+  int nLat, nLon, nDays;
+  int yearMin, nYears;
+
+  struct CompressedChunk {
+    vector<hsize_t> offset;
+    vector<Bytef> bytes;
+    bool ok;
+  };
+
+  // Fills the raw buffer and offset of chunk i (buffer is pre-sized)
+  template <class T> struct Chunks {
+    using Filler =
+        function<void(size_t i, vector<T> &raw, vector<hsize_t> &offset)>;
+  };
+
+  // Creates a deflate-filtered chunked dataset and writes all its chunks.
+  // Worker threads fill and compress chunks; this thread writes them as
+  // they arrive. At most 2 * numThreads chunks are held in memory.
+  template <class T = float>
+  hid_t writeChunked(hid_t loc, const string &name,
+                     const vector<hsize_t> &dims,
+                     const vector<hsize_t> &chunk, size_t nChunks,
+                     const typename Chunks<T>::Filler &filler) {
+    hid_t space = H5Screate_simple(dims.size(), dims.data(), nullptr);
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(dcpl, chunk.size(), chunk.data());
+    H5Pset_deflate(dcpl, level);
+    const T fill = H5Element<T>::fill;
+    H5Pset_fill_value(dcpl, H5Element<T>::memType(), &fill);
+
+    hid_t dset = H5Dcreate2(loc, name.c_str(), H5Element<T>::fileType(),
+                            space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    H5Pclose(dcpl);
+    H5Sclose(space);
+    if (dset < 0) {
+      cerr << "Cannot create dataset: " << name << endl;
+      return -1;
+    }
+
+    size_t chunkElems = 1;
+    for (hsize_t c : chunk)
+      chunkElems *= c;
+
+    mutex qMutex;
+    condition_variable qReady, qSpace;
+    queue<CompressedChunk> ready;
+    const size_t maxInFlight = 2 * static_cast<size_t>(numThreads);
+    atomic<size_t> next{0};
+
+    auto worker = [&]() {
+      vector<T> raw(chunkElems);
+      while (true) {
+        size_t i = next++;
+        if (i >= nChunks)
+          return;
+
+        CompressedChunk cc;
+        cc.offset.assign(dims.size(), 0);
+        fill_n(raw.begin(), chunkElems, fill);
+        filler(i, raw, cc.offset);
+
+        uLongf destLen = compressBound(chunkElems * sizeof(T));
+        cc.bytes.resize(destLen);
+        cc.ok = compress2(cc.bytes.data(), &destLen,
+                          reinterpret_cast<const Bytef *>(raw.data()),
+                          chunkElems * sizeof(T), level) == Z_OK;
+        cc.bytes.resize(destLen);
+
+        unique_lock<mutex> lock(qMutex);
+        qSpace.wait(lock, [&] { return ready.size() < maxInFlight; });
+        ready.push(move(cc));
+        qReady.notify_one();
+      }
+    };
+
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t)
+      workers.emplace_back(worker);
+
+    bool ok = true;
+    for (size_t written = 0; written < nChunks; ++written) {
+      CompressedChunk cc;
+      {
+        unique_lock<mutex> lock(qMutex);
+        qReady.wait(lock, [&] { return !ready.empty(); });
+        cc = move(ready.front());
+        ready.pop();
+        qSpace.notify_one();
+      }
+      if (!cc.ok ||
+          H5Dwrite_chunk(dset, H5P_DEFAULT, 0, cc.offset.data(),
+                         cc.bytes.size(), cc.bytes.data()) < 0) {
+        ok = false;
+      }
+    }
+
+    for (auto &w : workers)
+      w.join();
+
+    if (!ok) {
+      cerr << "Failed writing chunks of dataset: " << name << endl;
+      H5Dclose(dset);
+      return -1;
+    }
+    return dset;
+  }
+
+  // 1-D double coordinate variable registered as a dimension scale
+  hid_t writeScale(const string &name, const vector<double> &values,
+                   const char *units, const char *standardName) {
+    hsize_t n = values.size();
+    hid_t space = H5Screate_simple(1, &n, nullptr);
+    hid_t dset = H5Dcreate2(file, name.c_str(), H5T_IEEE_F64LE, space,
+                            H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Dwrite(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+             values.data());
+    H5Sclose(space);
+
+    H5DSset_scale(dset, name.c_str());
+    H5LTset_attribute_string(file, name.c_str(), "units", units);
+    if (standardName)
+      H5LTset_attribute_string(file, name.c_str(), "standard_name",
+                               standardName);
+    if (name.rfind("time", 0) == 0)
+      H5LTset_attribute_string(file, name.c_str(), "calendar", "standard");
+    return dset;
+  }
+
+  void describe(hid_t dset, const char *longName, const char *units) {
+    float fill = O3_MISSING;
+    hid_t space = H5Screate(H5S_SCALAR);
+    hid_t attr = H5Acreate2(dset, "_FillValue", H5T_IEEE_F32LE, space,
+                            H5P_DEFAULT, H5P_DEFAULT);
+    H5Awrite(attr, H5T_NATIVE_FLOAT, &fill);
+    H5Aclose(attr);
+    H5Sclose(space);
+    H5LTset_attribute_string(dset, ".", "long_name", longName);
+    H5LTset_attribute_string(dset, ".", "units", units);
+  }
+
+  // Mean of the valid (> 0) values of every cell, per calendar month and per
+  // year: monthly[cell * nYears * 12 + k], annual[cell * nYears + y]
+  void computeRollups(vector<float> &monthly, vector<float> &annual) {
+    const size_t nCells = static_cast<size_t>(nLat) * nLon;
+    monthly.assign(nCells * nYears * 12, O3_MISSING);
+    annual.assign(nCells * nYears, O3_MISSING);
+
+    // Month index of every day, shared by all cells
+    vector<int> dayMonth(nDays);
+    for (int i = 0; i < nDays; ++i) {
+      const O3Civil c = o3Civil(store.firstDay() + i);
+      dayMonth[i] = (c.year - yearMin) * 12 + (c.month - 1);
+    }
+
+    atomic<size_t> next{0};
+    auto worker = [&]() {
+      vector<double> mSum(nYears * 12), ySum(nYears);
+      vector<int> mCnt(nYears * 12), yCnt(nYears);
+      while (true) {
+        size_t c = next++;
+        if (c >= nCells)
+          return;
+        fill(mSum.begin(), mSum.end(), 0.0);
+        fill(ySum.begin(), ySum.end(), 0.0);
+        fill(mCnt.begin(), mCnt.end(), 0);
+        fill(yCnt.begin(), yCnt.end(), 0);
+
+        const float *s = store.cell(static_cast<O3CellId>(c));
+        for (int i = 0; i < nDays; ++i) {
+          if (s[i] > 0) {
+            mSum[dayMonth[i]] += s[i];
+            mCnt[dayMonth[i]]++;
+            ySum[dayMonth[i] / 12] += s[i];
+            yCnt[dayMonth[i] / 12]++;
+          }
+        }
+        for (int k = 0; k < nYears * 12; ++k)
+          if (mCnt[k] > 0)
+            monthly[c * nYears * 12 + k] = mSum[k] / mCnt[k];
+        for (int y = 0; y < nYears; ++y)
+          if (yCnt[y] > 0)
+            annual[c * nYears + y] = ySum[y] / yCnt[y];
+      }
+    };
+
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t)
+      workers.emplace_back(worker);
+    for (auto &w : workers)
+      w.join();
+  }
+
+public:
+  OzoneH5Exporter(const O3Store &store, int numThreads, int level)
+      : store(store), numThreads(numThreads), level(level) {
+    const O3StoreHeader &h = store.header();
+    nLat = h.nLat;
+    nLon = h.nLon;
+    nDays = h.nDays;
+
+    yearMin = o3Civil(store.firstDay()).year;
+    nYears = o3Civil(store.lastDay()).year - yearMin + 1;
+  }
+
+  bool exportTo(const string &outputFile) {
+    file = H5Fcreate(outputFile.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
+                     H5P_DEFAULT);
+    if (file < 0) {
+      cerr << "Cannot create HDF5 file: " << outputFile << endl;
+      return false;
+    }
+    H5LTset_attribute_string(file, "/", "Conventions", "CF-1.8");
+    H5LTset_attribute_string(file, "/", "title",
+                             "NODPAAT processed total column ozone");
+    H5LTset_attribute_string(
+        file, "/", "comment",
+        "Markers: -1 invalid satellite value, -2 placeholder year, "
+        "-3 missing day");
+
+    const O3StoreHeader &h = store.header();
+
+    // ---- coordinates ----
+    vector<double> lat(nLat), lon(nLon), time(nDays), timeMonth, timeYear;
+    for (int i = 0; i < nLat; ++i)
+      lat[i] = h.latMin + i * h.step;
+    for (int i = 0; i < nLon; ++i)
+      lon[i] = h.lonMin + i * h.step;
+    for (int i = 0; i < nDays; ++i)
+      time[i] = store.firstDay() + i;
+    for (int y = 0; y < nYears; ++y) {
+      timeYear.push_back(o3DaysFromCivil(yearMin + y, 1, 1));
+      for (int m = 1; m <= 12; ++m)
+        timeMonth.push_back(o3DaysFromCivil(yearMin + y, m, 1));
+    }
+
+    hid_t sLat = writeScale("lat", lat, "degrees_north", "latitude");
+    hid_t sLon = writeScale("lon", lon, "degrees_east", "longitude");
+    hid_t sTime = writeScale("time", time, "days since 1970-01-01", "time");
+    hid_t sMonth =
+        writeScale("time_month", timeMonth, "days since 1970-01-01", "time");
+    hid_t sYear =
+        writeScale("time_year", timeYear, "days since 1970-01-01", "time");
+
+    bool ok = true;
+    auto attach3 = [&](hid_t dset, hid_t tScale) {
+      H5DSattach_scale(dset, sLat, 0);
+      H5DSattach_scale(dset, sLon, 1);
+      H5DSattach_scale(dset, tScale, 2);
+    };
+
+    // ---- daily: read per location, so one chunk holds a whole series ----
+    auto t0 = chrono::high_resolution_clock::now();
+    const hsize_t tChunk = min<hsize_t>(nDays, 65536);
+    const size_t tChunks = (nDays + tChunk - 1) / tChunk;
+    hid_t daily = writeChunked(
+        file, "o3_daily",
+        {(hsize_t)nLat, (hsize_t)nLon, (hsize_t)nDays}, {1, 1, tChunk},
+        static_cast<size_t>(nLat) * nLon * tChunks,
+        [&](size_t i, vector<float> &raw, vector<hsize_t> &offset) {
+          size_t c = i / tChunks;
+          size_t t = (i % tChunks) * tChunk;
+          offset = {c / nLon, c % nLon, t};
+          const float *s = store.cell(static_cast<O3CellId>(c)) + t;
+          copy(s, s + min<size_t>(tChunk, nDays - t), raw.begin());
+        });
+    if (daily >= 0) {
+      describe(daily, "total column ozone", "DU");
+      attach3(daily, sTime);
+      H5Dclose(daily);
+    } else {
+      ok = false;
+    }
+
+    // Gap-filled stores (ozone_query fill): which daily values are
+    // estimates, 0 observed, k filled in place of the marker -k
+    if (store.filled(0)) {
+      hid_t flags = writeChunked<uint8_t>(
+          file, "o3_daily_filled",
+          {(hsize_t)nLat, (hsize_t)nLon, (hsize_t)nDays}, {1, 1, tChunk},
+          static_cast<size_t>(nLat) * nLon * tChunks,
+          [&](size_t i, vector<uint8_t> &raw, vector<hsize_t> &offset) {
+            size_t c = i / tChunks;
+            size_t t = (i % tChunks) * tChunk;
+            offset = {c / nLon, c % nLon, t};
+            const uint8_t *f = store.filled(static_cast<O3CellId>(c)) + t;
+            copy(f, f + min<size_t>(tChunk, nDays - t), raw.begin());
+          });
+      if (flags >= 0) {
+        H5LTset_attribute_string(flags, ".", "long_name",
+                                 "gap fill flag of o3_daily");
+        H5LTset_attribute_string(
+            flags, ".", "comment",
+            "0 observed, k estimated in place of the marker -k");
+        attach3(flags, sTime);
+        H5Dclose(flags);
+      } else {
+        ok = false;
+      }
+    }
+    auto t1 = chrono::high_resolution_clock::now();
+    cout << "Daily cube written in "
+         << chrono::duration_cast<chrono::milliseconds>(t1 - t0).count()
+         << " ms" << endl;
+
+    // ---- rollups: read as maps, so one chunk holds the whole grid ----
+    vector<float> monthly, annual;
+    computeRollups(monthly, annual);
+
+    hid_t dMonth = writeChunked(
+        file, "o3_monthly",
+        {(hsize_t)nLat, (hsize_t)nLon, (hsize_t)nYears * 12},
+        {(hsize_t)nLat, (hsize_t)nLon, 12}, nYears,
+        [&](size_t y, vector<float> &raw, vector<hsize_t> &offset) {
+          offset = {0, 0, y * 12};
+          for (size_t c = 0; c < (size_t)nLat * nLon; ++c)
+            for (int m = 0; m < 12; ++m)
+              raw[c * 12 + m] = monthly[c * nYears * 12 + y * 12 + m];
+        });
+    hid_t dYear = writeChunked(
+        file, "o3_annual", {(hsize_t)nLat, (hsize_t)nLon, (hsize_t)nYears},
+        {(hsize_t)nLat, (hsize_t)nLon, 1}, nYears,
+        [&](size_t y, vector<float> &raw, vector<hsize_t> &offset) {
+          offset = {0, 0, y};
+          for (size_t c = 0; c < (size_t)nLat * nLon; ++c)
+            raw[c] = annual[c * nYears + y];
+        });
+    if (dMonth >= 0 && dYear >= 0) {
+      describe(dMonth, "monthly mean total column ozone", "DU");
+      describe(dYear, "annual mean total column ozone", "DU");
+      attach3(dMonth, sMonth);
+      attach3(dYear, sYear);
+      H5Dclose(dMonth);
+      H5Dclose(dYear);
+    } else {
+      ok = false;
+    }
+
+    // ---- linear fit results from skim_<loc>/<loc>_fitlinear.dat ----
+    ok = exportFits() && ok;
+
+    H5Dclose(sLat);
+    H5Dclose(sLon);
+    H5Dclose(sTime);
+    H5Dclose(sMonth);
+    H5Dclose(sYear);
+    H5Fclose(file);
+    return ok;
+  }
+
+  bool exportFits() {
+    static const char *params[] = {"a0",   "a1",     "chi2_ndf", "chi2",
+                                   "ndf",  "err_a0", "err_a1",   "prob"};
+    const size_t nCells = static_cast<size_t>(nLat) * nLon;
+
+    // fits[row][param][cell]: row 0 all events, row 1 events > nEvOffSet
+    vector<float> fits(2 * 8 * nCells, O3_MISSING);
+    int found = 0;
+    const O3Grid grid = store.grid();
+    for (O3CellId c = 0; c < grid.size(); ++c) {
+      string loc = grid.name(c);
+      ifstream in("skim_" + loc + "/" + loc + "_fitlinear.dat");
+      if (!in.is_open())
+        continue;
+      float v;
+      for (int k = 0; k < 16 && in >> v; ++k)
+        fits[(k / 8) * 8 * nCells + (k % 8) * nCells + c] = v;
+      ++found;
+    }
+    cout << "Fit results found for " << found << " locations" << endl;
+
+    hid_t sLat = H5Dopen2(file, "lat", H5P_DEFAULT);
+    hid_t sLon = H5Dopen2(file, "lon", H5P_DEFAULT);
+    bool ok = true;
+    const char *groups[] = {"fit_all", "fit_cut"};
+    for (int row = 0; row < 2; ++row) {
+      hid_t grp = H5Gcreate2(file, groups[row], H5P_DEFAULT, H5P_DEFAULT,
+                             H5P_DEFAULT);
+      for (int p = 0; p < 8; ++p) {
+        const float *src = fits.data() + (row * 8 + p) * nCells;
+        hid_t d = writeChunked(
+            grp, params[p], {(hsize_t)nLat, (hsize_t)nLon},
+            {(hsize_t)nLat, (hsize_t)nLon}, 1,
+            [&](size_t, vector<float> &raw, vector<hsize_t> &offset) {
+              offset = {0, 0};
+              copy(src, src + nCells, raw.begin());
+            });
+        if (d < 0) {
+          ok = false;
+          continue;
+        }
+        describe(d, params[p], "1");
+        H5DSattach_scale(d, sLat, 0);
+        H5DSattach_scale(d, sLon, 1);
+        H5Dclose(d);
+      }
+      H5Gclose(grp);
+    }
+    H5Dclose(sLat);
+    H5Dclose(sLon);
+    return ok;
+  }
+};
+
+void printUsage(const char *programName) {
+  cout << "Usage: " << programName
+       << " <store_file> <output.h5> [num_threads] [deflate_level]" << endl;
+  cout << "Example: " << programName << " ozone.o3s ozone_10x10.h5 8 4"
+       << endl;
+  cout << "Fit results are read from skim_<location>/ in the current folder"
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  int numThreads = (argc >= 4) ? stoi(argv[3]) : 0;
+  if (numThreads <= 0)
+    numThreads = max(1u, thread::hardware_concurrency());
+  int level = (argc == 5) ? stoi(argv[4]) : 4;
+
+  auto start = chrono::high_resolution_clock::now();
+  try {
+    O3Store store(argv[1]);
+    OzoneH5Exporter exporter(store, numThreads, level);
+    if (!exporter.exportTo(argv[2])) {
+      cerr << "HDF5 export failed" << endl;
+      return 1;
+    }
+  } catch (const exception &e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+  auto end = chrono::high_resolution_clock::now();
+  cout << "Exported " << argv[2] << " in "
+       << chrono::duration_cast<chrono::milliseconds>(end - start).count()
+       << " ms" << endl;
+  return 0;
+}
@@ -0,0 +1,177 @@
+// ozone_merge.cpp
+// Combines the run directories of a sharded run (optimized_ozone_processor
+// --shard i/N) into one: every planned location's <location>/ and
+// skim_<location>/ (series, chi2 fits and stats) and its manifest record.
+// The merge checks that all N shards are present and that every planned
+// location finished; merging the same shard twice is harmless.
+#include "include/o3Manifest.h"
+#include "include/o3Shard.h"
+
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+struct ShardDir {
+  string path;
+  O3Shard shard;
+  vector<string> locations;
+};
+
+// Copies (or moves) one folder into the output, replacing what was there
+bool transferDir(const fs::path &from, const fs::path &to, bool moveDir) {
+  error_code ec;
+  fs::remove_all(to, ec);
+  if (moveDir) {
+    fs::rename(from, to, ec);
+    if (!ec)
+      return true;
+    // Other file system: fall back to copy and remove
+  }
+  ec.clear();
+  fs::copy(from, to, fs::copy_options::recursive, ec);
+  if (ec) {
+    cerr << "Cannot copy " << from << ": " << ec.message() << endl;
+    return false;
+  }
+  if (moveDir)
+    fs::remove_all(from, ec);
+  return true;
+}
+
+bool mergeShards(const string &outDir, const vector<string> &shardPaths,
+                 bool moveDirs) {
+  // Plans first: nothing is written unless the shard set is complete
+  vector<ShardDir> shards;
+  map<int, string> byIndex;
+  int count = 0;
+  for (const string &path : shardPaths) {
+    ShardDir sd;
+    sd.path = path;
+    const string planPath = (fs::path(path) / O3_SHARD_PLAN_NAME).string();
+    if (!o3ReadShardPlan(planPath, sd.shard, sd.locations)) {
+      cerr << "Cannot read shard plan: " << planPath << endl;
+      return false;
+    }
+    if (count == 0)
+      count = sd.shard.count;
+    if (sd.shard.count != count) {
+      cerr << path << " is shard " << sd.shard.index << "/" << sd.shard.count
+           << ", other shards are of " << count << endl;
+      return false;
+    }
+    if (!byIndex.emplace(sd.shard.index, path).second) {
+      cerr << "Shard " << sd.shard.index << " given twice: "
+           << byIndex[sd.shard.index] << " and " << path << endl;
+      return false;
+    }
+    shards.push_back(move(sd));
+  }
+  bool complete = true;
+  for (int i = 1; i <= count; ++i) {
+    if (!byIndex.count(i)) {
+      cerr << "Missing shard " << i << "/" << count << endl;
+      complete = false;
+    }
+  }
+  if (!complete)
+    return false;
+
+  fs::create_directories(outDir);
+  O3Manifest merged((fs::path(outDir) / O3_MANIFEST_NAME).string());
+
+  size_t copied = 0, already = 0, unfinished = 0;
+  for (const ShardDir &sd : shards) {
+    O3Manifest manifest((fs::path(sd.path) / O3_MANIFEST_NAME).string());
+    for (const string &loc : sd.locations) {
+      const fs::path skimFrom = fs::path(sd.path) / ("skim_" + loc);
+      const fs::path skimTo = fs::path(outDir) / ("skim_" + loc);
+      const string skimFile = "skim_" + loc + "/" + loc + ".dat";
+
+      O3ManifestRecord rec;
+      uint64_t bytes = 0;
+      if (!manifest.find(loc, rec) || rec.status != "done") {
+        cerr << "Not finished in shard " << sd.shard.index << ": " << loc
+             << endl;
+        ++unfinished;
+        continue;
+      }
+
+      // Already merged (same skim output): only the record is kept
+      O3ManifestRecord have;
+      if (merged.find(loc, have) && have.status == "done" &&
+          have.output == rec.output &&
+          o3FileChecksum((fs::path(outDir) / skimFile).string(), &bytes) ==
+              rec.output) {
+        ++already;
+        continue;
+      }
+
+      if (o3FileChecksum((fs::path(sd.path) / skimFile).string(), &bytes) !=
+              rec.output ||
+          bytes != rec.outputBytes) {
+        cerr << "Skim output of " << loc << " in " << sd.path
+             << " does not match its manifest record" << endl;
+        ++unfinished;
+        continue;
+      }
+
+      const fs::path locFrom = fs::path(sd.path) / loc;
+      if (fs::is_directory(locFrom) &&
+          !transferDir(locFrom, fs::path(outDir) / loc, moveDirs))
+        return false;
+      if (!transferDir(skimFrom, skimTo, moveDirs))
+        return false;
+      merged.append(loc, rec);
+      ++copied;
+    }
+  }
+
+  cout << "Merged " << shards.size() << " shards into " << outDir << ": "
+       << copied << " locations " << (moveDirs ? "moved" : "copied") << ", "
+       << already << " already present, " << unfinished << " unfinished"
+       << endl;
+  return unfinished == 0;
+}
+
+void printUsage(const char *programName) {
+  cout << "Usage: " << programName
+       << " <output_dir> <shard_dir> [shard_dir ...] [--move]" << endl;
+  cout << endl;
+  cout << "Each shard_dir is the working directory of one "
+          "'optimized_ozone_processor ... --shard i/N'"
+       << endl;
+  cout << "run. --move renames the location folders instead of copying them."
+       << endl;
+  cout << endl;
+  cout << "Example:" << endl;
+  cout << programName << " merged/ node1/ node2/ node3/" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  bool moveDirs = false;
+  vector<string> args;
+  for (int i = 1; i < argc; ++i) {
+    if (string(argv[i]) == "--move")
+      moveDirs = true;
+    else
+      args.push_back(argv[i]);
+  }
+  if (args.size() < 2) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    const vector<string> shardPaths(args.begin() + 1, args.end());
+    return mergeShards(args[0], shardPaths, moveDirs) ? 0 : 1;
+  } catch (const exception &e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+}
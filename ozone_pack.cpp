@@ -0,0 +1,181 @@
+// ozone_pack.cpp
+// Packs the per-location folders of a run (<location>/ with the yearly
+// .dat files and skim_<location>/ with the skim and chi2 files) into one
+// archive with a hashed footer index, and reads artifacts back from it.
+#include "include/o3Archive.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+// A location folder holds files named <folder>_*; skim folders are
+// skim_<location>
+bool isLocationDir(const fs::path &dir) {
+  const string name = dir.filename().string();
+  if (name.rfind("skim_", 0) == 0)
+    return true;
+  for (const auto &entry : fs::directory_iterator(dir)) {
+    if (entry.is_regular_file() &&
+        entry.path().filename().string().rfind(name + "_", 0) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool packRun(const string &archivePath, const string &runDir, bool remove) {
+  vector<fs::path> dirs;
+  for (const auto &entry : fs::directory_iterator(runDir)) {
+    if (entry.is_directory() && isLocationDir(entry.path()))
+      dirs.push_back(entry.path());
+  }
+  sort(dirs.begin(), dirs.end());
+
+  O3ArchiveWriter writer(archivePath);
+  uint64_t bytes = 0;
+
+  for (const auto &dir : dirs) {
+    vector<fs::path> files;
+    for (const auto &entry : fs::directory_iterator(dir)) {
+      if (entry.is_regular_file())
+        files.push_back(entry.path());
+    }
+    sort(files.begin(), files.end());
+
+    for (const auto &file : files) {
+      string location, artifact;
+      const string rel = dir.filename().string() + "/" +
+                         file.filename().string();
+      if (!o3ArchiveKey(rel, location, artifact))
+        continue;
+      if (!writer.addFile(location, artifact, file.string())) {
+        cerr << "Cannot read: " << file << endl;
+        return false;
+      }
+      bytes += fs::file_size(file);
+    }
+  }
+
+  if (!writer.finish()) {
+    cerr << "Cannot write archive: " << archivePath << endl;
+    return false;
+  }
+
+  cout << "Packed " << writer.size() << " files (" << bytes << " bytes) from "
+       << dirs.size() << " folders into " << archivePath << endl;
+
+  if (remove) {
+    for (const auto &dir : dirs)
+      fs::remove_all(dir);
+    cout << "Removed " << dirs.size() << " packed folders" << endl;
+  }
+  return true;
+}
+
+bool listArchive(const string &archivePath, const string &location) {
+  O3Archive archive(archivePath);
+  auto items = archive.list(location);
+  sort(items.begin(), items.end());
+  for (const auto &[loc, artifact] : items) {
+    cout << loc << '\t' << artifact << '\t'
+         << archive.find(loc, artifact).size() << endl;
+  }
+  return true;
+}
+
+bool catArtifact(const string &archivePath, const string &location,
+                 const string &artifact) {
+  O3Archive archive(archivePath);
+  auto start = chrono::high_resolution_clock::now();
+  string_view blob = archive.find(location, artifact);
+  auto end = chrono::high_resolution_clock::now();
+  if (!blob.data()) {
+    cerr << "Not in archive: " << location << " " << artifact << endl;
+    return false;
+  }
+  cout.write(blob.data(), blob.size());
+  cerr << "Lookup time: "
+       << chrono::duration_cast<chrono::nanoseconds>(end - start).count()
+       << " ns" << endl;
+  return true;
+}
+
+// Restores the original folder layout
+bool unpackArchive(const string &archivePath, const string &outDir) {
+  O3Archive archive(archivePath);
+  size_t n = 0;
+  for (const auto &[loc, artifact] : archive.list()) {
+    fs::path target;
+    if (artifact.rfind("skim/", 0) == 0)
+      target = fs::path(outDir) / ("skim_" + loc) / artifact.substr(5);
+    else
+      target = fs::path(outDir) / loc / artifact;
+    fs::create_directories(target.parent_path());
+
+    string_view blob = archive.find(loc, artifact);
+    ofstream out(target, ios::binary);
+    out.write(blob.data(), blob.size());
+    if (!out) {
+      cerr << "Cannot write: " << target << endl;
+      return false;
+    }
+    ++n;
+  }
+  cout << "Unpacked " << n << " files into " << outDir << endl;
+  return true;
+}
+
+void printUsage(const char *programName) {
+  cout << "Usage:" << endl;
+  cout << programName << " pack <archive> [run_dir] [--remove]" << endl;
+  cout << programName << " list <archive> [location]" << endl;
+  cout << programName << " cat <archive> <location> <artifact>" << endl;
+  cout << programName << " unpack <archive> <output_dir>" << endl;
+  cout << endl;
+  cout << "Examples:" << endl;
+  cout << programName << " pack run.o3a . --remove" << endl;
+  cout << programName << " cat run.o3a LAT0LON0 skim/LAT0LON0_snavuderr.dat"
+       << endl;
+  cout << "The chi2 app and the viewer read run.o3a (or $O3_ARCHIVE) when a "
+          "file is not on disk."
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  string mode = argv[1];
+  try {
+    if (mode == "pack") {
+      string runDir = ".";
+      bool remove = false;
+      for (int i = 3; i < argc; ++i) {
+        if (string(argv[i]) == "--remove")
+          remove = true;
+        else
+          runDir = argv[i];
+      }
+      return packRun(argv[2], runDir, remove) ? 0 : 1;
+    } else if (mode == "list") {
+      return listArchive(argv[2], argc > 3 ? argv[3] : "") ? 0 : 1;
+    } else if (mode == "cat" && argc == 5) {
+      return catArtifact(argv[2], argv[3], argv[4]) ? 0 : 1;
+    } else if (mode == "unpack" && argc == 4) {
+      return unpackArchive(argv[2], argv[3]) ? 0 : 1;
+    }
+  } catch (const exception &e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  printUsage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,331 @@
+// ozone_query.cpp
+// Builds the dense series store from skim_<location>/ folders and answers
+// point queries from it without re-running the extraction pipeline.
+#include "include/npyWriter.h"
+#include "include/o3Store.h"
+#include "include/o3StoreFill.h"
+#include "include/o3TextIO.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace std;
+
+// Time axis of the skim files (same range as the chi2 study)
+constexpr int YMIN = 1979;
+constexpr int YMAX = 2024;
+
+// Parse YYYY-MM-DD into days since epoch
+bool parseDate(const string &s, int32_t &day) {
+  int y, m, d;
+  if (sscanf(s.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 ||
+      d < 1 || d > o3DaysInMonth(y, m))
+    return false;
+  day = o3DaysFromCivil(y, m, d);
+  return true;
+}
+
+bool buildStore(const string &storePath, double latMin, double latMax,
+                double lonMin, double lonMax, double gridPrecision) {
+  if (gridPrecision <= 0 || latMin > latMax || lonMin > lonMax) {
+    cerr << "Invalid grid bounds or precision" << endl;
+    return false;
+  }
+  const O3Grid grid(latMin, latMax, lonMin, lonMax, gridPrecision);
+  const int32_t day0 = o3DaysFromCivil(YMIN, 1, 1);
+  const int32_t nDays = o3DaysFromCivil(YMAX, 12, 31) - day0 + 1;
+
+  cout << "Building store " << storePath << ": " << grid.nLat << "x"
+       << grid.nLon << " cells, " << nDays << " days" << endl;
+
+  O3StoreWriter writer(storePath, grid, day0, nDays);
+
+  vector<float> series(nDays);
+  int found = 0;
+
+  for (O3CellId id = 0; id < grid.size(); ++id) {
+    const string location = grid.name(id);
+    const string fileName = "skim_" + location + "/" + location + ".dat";
+
+    O3TextReader inFile;
+    if (!inFile.open(fileName))
+      continue;
+
+    fill(series.begin(), series.end(), O3_MISSING);
+
+    int dd, mm, yy;
+    float value;
+    while (inFile.row(dd, mm, yy, value)) {
+      const int32_t idx = o3DaysFromCivil(yy, mm, dd) - day0;
+      if (idx >= 0 && idx < nDays)
+        series[idx] = value;
+    }
+
+    writer.writeCell(id, series.data());
+    ++found;
+  }
+
+  cout << "Stored " << found << " of " << grid.size() << " locations" << endl;
+  return found > 0;
+}
+
+bool querySeries(const string &storePath, double lat, double lon, int32_t t0,
+                 int32_t t1, O3Interp mode, bool observedOnly) {
+  O3Store store(storePath);
+  if (!store.covers(lat, lon)) {
+    cerr << "Error: " << lat << ", " << lon << " is outside the store grid"
+         << endl;
+    return false;
+  }
+
+  auto start = chrono::high_resolution_clock::now();
+  vector<float> values = store.series(lat, lon, t0, t1, mode, observedOnly);
+  auto end = chrono::high_resolution_clock::now();
+
+  int32_t day = max(t0, store.firstDay());
+  int y, m, d;
+  for (float v : values) {
+    o3CivilFromDays(day++, y, m, d);
+    printf("%d\t%d\t%d\t%g\n", d, m, y, v);
+  }
+
+  cerr << "Query time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count()
+       << " us (" << values.size() << " days)" << endl;
+  return true;
+}
+
+// Writes a gap-filled copy of the store (o3StoreFill.h)
+bool fillStore(const string &storePath, const string &outPath,
+               const O3StoreFillOptions &options) {
+  O3Store store(storePath);
+  if (store.header().flagsOffset) {
+    cerr << "Error: " << storePath << " is already gap filled" << endl;
+    return false;
+  }
+
+  auto start = chrono::high_resolution_clock::now();
+  const O3StoreFillResult r = O3StoreFiller(store, options).run(outPath);
+  auto end = chrono::high_resolution_clock::now();
+
+  cout << "Filled " << r.filledDays << " days in " << r.cellsWithData << " of "
+       << r.cells << " cells (mean lag-1 autocorrelation " << r.meanPhi
+       << "), " << r.leftDays << " left missing" << endl;
+  cout << "Fill time: "
+       << chrono::duration_cast<chrono::milliseconds>(end - start).count()
+       << " ms" << endl;
+  return true;
+}
+
+// Writes the whole cube as (nLat, nLon, nDays) float32 plus the lat, lon and
+// day (days since 1970-01-01) axes, straight from the mapped store; a
+// gap-filled store also gets its (nLat, nLon, nDays) uint8 fill flags
+bool exportCubeNpy(const string &storePath, const string &npyPath) {
+  O3Store store(storePath);
+  const O3StoreHeader &h = store.header();
+
+  NpyWriter<float> npy(npyPath, {(size_t)h.nLon, (size_t)h.nDays});
+  for (int iLat = 0; iLat < h.nLat; ++iLat)
+    npy.write(store.cell(iLat, 0), 1);
+  if (!npy.close()) {
+    cerr << "Cannot write " << npyPath << endl;
+    return false;
+  }
+
+  string base = npyPath.substr(0, npyPath.rfind(".npy"));
+  vector<double> lat(h.nLat), lon(h.nLon);
+  vector<int32_t> days(h.nDays);
+  for (int i = 0; i < h.nLat; ++i)
+    lat[i] = h.latMin + i * h.step;
+  for (int i = 0; i < h.nLon; ++i)
+    lon[i] = h.lonMin + i * h.step;
+  for (int i = 0; i < h.nDays; ++i)
+    days[i] = h.day0 + i;
+
+  bool ok = npySave(base + "_lat.npy", lat.data(), {lat.size()}) &&
+            npySave(base + "_lon.npy", lon.data(), {lon.size()}) &&
+            npySave(base + "_day.npy", days.data(), {days.size()});
+  if (store.filled(0)) {
+    NpyWriter<uint8_t> flags(base + "_filled.npy",
+                             {(size_t)h.nLon, (size_t)h.nDays});
+    for (int iLat = 0; iLat < h.nLat; ++iLat)
+      flags.write(store.filled(iLat, 0), 1);
+    ok = flags.close() && ok;
+  }
+  cout << "Exported " << h.nLat << "x" << h.nLon << "x" << h.nDays
+       << " cube to " << npyPath << endl;
+  return ok;
+}
+
+// Writes one point series as (n, 2) float64 rows: day since epoch, value
+bool exportSeriesNpy(const string &storePath, const string &npyPath,
+                     double lat, double lon, int32_t t0, int32_t t1,
+                     O3Interp mode, bool observedOnly) {
+  O3Store store(storePath);
+  if (!store.covers(lat, lon)) {
+    cerr << "Error: " << lat << ", " << lon << " is outside the store grid"
+         << endl;
+    return false;
+  }
+  vector<float> values = store.series(lat, lon, t0, t1, mode, observedOnly);
+
+  NpyWriter<double> npy(npyPath, {2});
+  int32_t day = max(t0, store.firstDay());
+  for (float v : values) {
+    const double row[2] = {(double)day++, v};
+    npy.writeRow(row);
+  }
+  return npy.close();
+}
+
+void printUsage(const char *programName) {
+  cout << "Usage for building a store from skim_<location>/ folders:" << endl;
+  cout << programName
+       << " build <store_file> <lat_min> <lat_max> <lon_min> <lon_max> "
+          "<grid_precision>"
+       << endl;
+  cout << endl;
+  cout << "Usage for a point query:" << endl;
+  cout << programName
+       << " series <store_file> <lat> <lon> <YYYY-MM-DD> <YYYY-MM-DD> "
+          "[nearest|bilinear] [observed]"
+       << endl;
+  cout << endl;
+  cout << "Usage for NumPy export (whole cube, or one point series):" << endl;
+  cout << programName
+       << " npy <store_file> <output.npy> [<lat> <lon> <YYYY-MM-DD> "
+          "<YYYY-MM-DD> [nearest|bilinear] [observed]]"
+       << endl;
+  cout << endl;
+  cout << "Usage for gap filling (climatology plus anomaly):" << endl;
+  cout << programName
+       << " fill <store_file> <output_store> [temporal|spatial|none] "
+          "[<max_gap_days>]"
+       << endl;
+  cout << "  observed: read filled days as the markers they replaced" << endl;
+  cout << endl;
+  cout << "Examples:" << endl;
+  cout << programName << " build ozone.o3s -90 90 -180 180 10" << endl;
+  cout << programName
+       << " series ozone.o3s 4.36 -74.04 2005-01-01 2005-12-31 bilinear"
+       << endl;
+  cout << programName << " npy ozone.o3s ozone_10x10.npy" << endl;
+  cout << programName << " fill ozone.o3s ozone_filled.o3s spatial 30" << endl;
+}
+
+// Parses the optional interpolation argument
+bool parseInterp(const string &im, O3Interp &interp) {
+  if (im == "bilinear") {
+    interp = O3Interp::Bilinear;
+  } else if (im == "nearest") {
+    interp = O3Interp::Nearest;
+  } else {
+    cerr << "Error: unknown interpolation: " << im << endl;
+    return false;
+  }
+  return true;
+}
+
+// Parses the optional trailing arguments of series and npy, from argv[first]:
+// [nearest|bilinear] [observed]
+bool parseQueryOptions(int argc, char *argv[], int first, O3Interp &interp,
+                       bool &observedOnly) {
+  interp = O3Interp::Nearest;
+  observedOnly = false;
+  for (int i = first; i < argc; ++i) {
+    if (string(argv[i]) == "observed") {
+      observedOnly = true;
+    } else if (i > first) {
+      cerr << "Error: unknown option: " << argv[i] << endl;
+      return false;
+    } else if (!parseInterp(argv[i], interp)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  string mode = argv[1];
+
+  try {
+    if (mode == "build") {
+      if (argc != 8) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      return buildStore(argv[2], stod(argv[3]), stod(argv[4]), stod(argv[5]),
+                        stod(argv[6]), stod(argv[7]))
+                 ? 0
+                 : 1;
+    } else if (mode == "series") {
+      if (argc < 7 || argc > 9) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      int32_t t0, t1;
+      if (!parseDate(argv[5], t0) || !parseDate(argv[6], t1)) {
+        cerr << "Error: dates must be YYYY-MM-DD" << endl;
+        return 1;
+      }
+      O3Interp interp;
+      bool observedOnly;
+      if (!parseQueryOptions(argc, argv, 7, interp, observedOnly))
+        return 1;
+      return querySeries(argv[2], stod(argv[3]), stod(argv[4]), t0, t1, interp,
+                         observedOnly)
+                 ? 0
+                 : 1;
+    } else if (mode == "npy") {
+      if (argc == 4)
+        return exportCubeNpy(argv[2], argv[3]) ? 0 : 1;
+      if (argc < 8 || argc > 10) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      int32_t t0, t1;
+      if (!parseDate(argv[6], t0) || !parseDate(argv[7], t1)) {
+        cerr << "Error: dates must be YYYY-MM-DD" << endl;
+        return 1;
+      }
+      O3Interp interp;
+      bool observedOnly;
+      if (!parseQueryOptions(argc, argv, 8, interp, observedOnly))
+        return 1;
+      return exportSeriesNpy(argv[2], argv[3], stod(argv[4]), stod(argv[5]),
+                             t0, t1, interp, observedOnly)
+                 ? 0
+                 : 1;
+    } else if (mode == "fill") {
+      if (argc < 4 || argc > 6) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      O3StoreFillOptions options;
+      if (argc >= 5 && !o3ParseAnomaly(argv[4], options.anomaly)) {
+        cerr << "Error: unknown anomaly estimate: " << argv[4] << endl;
+        return 1;
+      }
+      if (argc == 6)
+        options.maxGap = stoi(argv[5]);
+      return fillStore(argv[2], argv[3], options) ? 0 : 1;
+    }
+  } catch (const exception &e) {
+    cerr << "Error: " << e.what() << endl;
+    return 1;
+  }
+
+  cout << "Unknown mode: " << mode << endl;
+  printUsage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,48 @@
+// o3Check.h
+// Minimal checks for the programs in tests/ (make check). O3_CHECK works in
+// optimized (NDEBUG) builds, reports every failing expression and lets the
+// program go on; o3CheckResult gives the exit status.
+//
+//   O3_CHECK(o3DaysFromCivil(1970, 1, 1) == 0);
+//   return o3CheckResult("testDate");
+
+#ifndef O3CHECK_H
+#define O3CHECK_H
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+#define O3_CHECK(cond) o3Check((cond), #cond, __FILE__, __LINE__)
+
+inline int &o3CheckFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+inline bool o3Check(bool ok, const char *expr, const char *file, int line) {
+  if (!ok) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    ++o3CheckFailures();
+  }
+  return ok;
+}
+
+// Scratch file path in the temp directory, unique to this process
+inline std::string o3CheckTempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() /
+          ("o3check_" + std::to_string(::getpid()) + "_" + name))
+      .string();
+}
+
+inline int o3CheckResult(const char *test) {
+  if (o3CheckFailures() == 0) {
+    std::printf("%s: ok\n", test);
+    return 0;
+  }
+  std::printf("%s: %d checks failed\n", test, o3CheckFailures());
+  return 1;
+}
+
+#endif
@@ -0,0 +1,70 @@
+// testDate.cpp
+// o3Date.h against an independent day-by-day calendar walk over 1900-2100,
+// and the date parser.
+#include "../include/o3Date.h"
+#include "o3Check.h"
+
+int main() {
+  // Walk the calendar one day at a time from 1900-01-01 (day -25567)
+  int y = 1900, m = 1, d = 1, doy = 1;
+  int32_t day = -25567;
+  bool civil = true, inverse = true, dayOfYear = true, month = true,
+       slots = true;
+  int32_t leapDays = 0;
+  while (y <= 2100) {
+    const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    static const int lengths[] = {31, 28, 31, 30, 31, 30,
+                                  31, 31, 30, 31, 30, 31};
+    const int monthLength = lengths[m - 1] + (m == 2 && leap);
+
+    civil = civil && o3DaysFromCivil(y, m, d) == day;
+    const O3Civil c = o3Civil(day);
+    int cy, cm, cd;
+    o3CivilFromDays(day, cy, cm, cd);
+    inverse = inverse && c.year == y && c.month == m && c.day == d &&
+              cy == y && cm == m && cd == d;
+    dayOfYear = dayOfYear && o3DayOfYear(day) == doy &&
+                o3IsLeap(y) == leap && o3DaysInYear(y) == 365 + leap &&
+                o3DaysInMonth(y, m) == monthLength;
+    month = month && o3MonthOfDayOfYear(doy, leap) == m;
+    // Leap slots: Feb 29 is 59, every other date shares its slot with
+    // the same date of a leap year
+    slots = slots && o3LeapSlot(day) == o3LeapSlot(o3DaysFromCivil(2000, m, d));
+    leapDays += o3LeapSlot(day) == 59;
+
+    ++day;
+    ++doy;
+    if (++d > monthLength) {
+      d = 1;
+      if (++m > 12) {
+        m = 1;
+        doy = 1;
+        O3_CHECK(o3YearRange(y).last == day - 1);
+        ++y;
+        if (y <= 2100)
+          O3_CHECK(o3YearRange(y).first == day);
+      }
+    }
+  }
+  O3_CHECK(civil);
+  O3_CHECK(inverse);
+  O3_CHECK(dayOfYear);
+  O3_CHECK(month);
+  O3_CHECK(slots);
+  O3_CHECK(leapDays == 49); // 1904-2096; 1900 and 2100 are not leap years
+  O3_CHECK(day == o3DaysFromCivil(2101, 1, 1));
+
+  // Parser: digit fields of valid dates only
+  int32_t parsed = 0;
+  O3_CHECK(o3ParseCivil("2005", "01", "01", parsed) && parsed == 12784);
+  O3_CHECK(o3ParseCivil("2024", "02", "29", parsed) &&
+           parsed == o3DaysFromCivil(2024, 2, 29));
+  O3_CHECK(!o3ParseCivil("2023", "02", "29", parsed));
+  O3_CHECK(!o3ParseCivil("1900", "02", "29", parsed));
+  O3_CHECK(!o3ParseCivil("2005", "13", "01", parsed));
+  O3_CHECK(!o3ParseCivil("2005", "1a", "01", parsed));
+  O3_CHECK(!o3ParseCivil("2005", "", "01", parsed));
+  O3_CHECK(!o3ParseCivil("0", "01", "01", parsed));
+
+  return o3CheckResult("testDate");
+}
@@ -0,0 +1,129 @@
+// testGapFill.cpp
+// o3FillGaps on synthetic skims with known gaps: marker, linear and
+// climatology fills, flags, and years added for gaps outside the skim.
+#include "../include/o3Pipeline.h"
+#include "../include/o3Store.h"
+#include "o3Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Skim of the years with value(day) on every day
+template <class F> static O3SkimSeries makeSkim(int y0, int y1, F value) {
+  O3SkimSeries skim;
+  for (int y = y0; y <= y1; ++y) {
+    skim.years.push_back(y);
+    const O3DayRange r = o3YearRange(y);
+    for (int32_t d = r.first; d <= r.last; ++d)
+      skim.values.push_back(value(d));
+  }
+  return skim;
+}
+
+// Position of day in a skim starting on Jan 1 of y0
+static size_t at(int y0, int32_t day) {
+  return static_cast<size_t>(day - o3DaysFromCivil(y0, 1, 1));
+}
+
+int main() {
+  O3GapFill mode;
+  O3_CHECK(o3ParseGapFill("linear", mode) && mode == O3GapFill::Linear);
+  O3_CHECK(!o3ParseGapFill("cubic", mode));
+
+  // Marker: the placeholder year, no estimates
+  {
+    O3SkimSeries skim = makeSkim(1994, 1996, [](int32_t) { return 300.0f; });
+    O3_CHECK(o3FillGaps(skim, {o3YearRange(1995)}, O3GapFill::Marker) == 0);
+    const O3DayRange g = o3YearRange(1995);
+    bool marked = true;
+    for (int32_t d = g.first; d <= g.last; ++d)
+      marked = marked && skim.values[at(1994, d)] == O3_PLACEHOLDER;
+    O3_CHECK(marked);
+    O3_CHECK(skim.values[at(1994, g.first - 1)] == 300.0f &&
+             skim.values[at(1994, g.last + 1)] == 300.0f);
+  }
+
+  // Linear: a straight line is recovered exactly inside the gap
+  {
+    const int32_t d0 = o3DaysFromCivil(2000, 1, 1);
+    auto line = [d0](int32_t d) { return 250.0f + 0.1f * (d - d0); };
+    O3SkimSeries skim = makeSkim(2000, 2001, line);
+    const O3DayRange gap{o3DaysFromCivil(2000, 12, 20),
+                         o3DaysFromCivil(2001, 1, 10)};
+    // Values inside the gap do not count as valid
+    skim.values[at(2000, gap.first + 3)] = 999.0f;
+    const size_t n = o3FillGaps(skim, {gap}, O3GapFill::Linear);
+    O3_CHECK(n == static_cast<size_t>(gap.last - gap.first + 1));
+    double maxErr = 0;
+    size_t flagged = 0;
+    for (int32_t d = d0; d <= o3DaysFromCivil(2001, 12, 31); ++d) {
+      const size_t i = at(2000, d);
+      maxErr = std::max(maxErr, std::fabs(skim.values[i] - line(d)) + 0.0);
+      flagged += skim.filled[i];
+      O3_CHECK(skim.filled[i] == (d >= gap.first && d <= gap.last));
+    }
+    O3_CHECK(maxErr < 1e-3);
+    O3_CHECK(flagged == n);
+
+    // A gap at the start has one side only: the nearest valid value
+    O3SkimSeries edge = makeSkim(2000, 2000, line);
+    o3FillGaps(edge, {{d0, d0 + 4}}, O3GapFill::Linear);
+    O3_CHECK(edge.values[0] == line(d0 + 5) && edge.values[4] == line(d0 + 5));
+
+    // Nothing to interpolate from: the marker, unflagged
+    O3SkimSeries empty = makeSkim(2000, 2000, [](int32_t) { return -1.0f; });
+    O3_CHECK(o3FillGaps(empty, {{d0, d0 + 4}}, O3GapFill::Linear) == 0);
+    O3_CHECK(empty.values[0] == O3_PLACEHOLDER && empty.filled[0] == 0);
+  }
+
+  // Climatology: a series that only depends on the calendar day is
+  // recovered, and a gap year missing from the skim is added
+  {
+    auto seasonal = [](int32_t d) {
+      return 280.0f + 20.0f * std::sin(o3LeapSlot(d) * 0.0172f);
+    };
+    O3SkimSeries skim = makeSkim(1993, 1997, seasonal);
+    // Drop 1995 from the skim: the gap brings it back
+    const size_t from = at(1993, o3DaysFromCivil(1995, 1, 1));
+    skim.values.erase(skim.values.begin() + from,
+                      skim.values.begin() + from + 365);
+    skim.years = {1993, 1994, 1996, 1997};
+
+    const O3DayRange y95 = o3YearRange(1995);
+    const O3DayRange feb96{o3DaysFromCivil(1996, 2, 29),
+                           o3DaysFromCivil(1996, 2, 29)};
+    const size_t n = o3FillGaps(skim, {y95, feb96}, O3GapFill::Climatology);
+    O3_CHECK((skim.years == std::vector<int>{1993, 1994, 1995, 1996, 1997}));
+    O3_CHECK(skim.values.size() == 4 * 365 + 366u);
+    O3_CHECK(n == 365);
+
+    double maxErr = 0;
+    for (int32_t d = y95.first; d <= y95.last; ++d)
+      maxErr = std::max(
+          maxErr, std::fabs(skim.values[at(1993, d)] - seasonal(d)) + 0.0);
+    O3_CHECK(maxErr < 1e-3);
+    // Feb 29 is its own slot; its only year is the gap, so no estimate
+    const size_t leapDay = at(1993, feb96.first);
+    O3_CHECK(skim.values[leapDay] == O3_PLACEHOLDER &&
+             skim.filled[leapDay] == 0);
+  }
+
+  // o3Skim / o3SkimYears round trip
+  {
+    O3LocationSeries series;
+    series[2004] = {{o3DaysFromCivil(2004, 2, 29), 301.5f},
+                    {o3DaysFromCivil(2004, 12, 31), 299.0f}};
+    const O3SkimSeries skim = o3Skim(series);
+    O3_CHECK(skim.years == std::vector<int>{2004} &&
+             skim.values.size() == 366);
+    O3_CHECK(skim.values[59] == 301.5f && skim.values[365] == 299.0f &&
+             skim.values[0] == O3_MISSING);
+    const O3LocationSeries back = o3SkimYears(skim);
+    O3_CHECK(back.at(2004).size() == 366 &&
+             back.at(2004)[59].day == o3DaysFromCivil(2004, 2, 29) &&
+             back.at(2004)[59].value == 301.5f);
+  }
+
+  return o3CheckResult("testGapFill");
+}
@@ -0,0 +1,81 @@
+// testShard.cpp
+// --shard i/N: every location lands in exactly one shard, the partition is
+// deterministic and balanced by cost, and shard plans read back.
+#include "../include/o3Shard.h"
+#include "o3Check.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+int main() {
+  O3Shard shard;
+  O3_CHECK(o3ParseShard("2/5", shard) && shard.index == 2 && shard.count == 5);
+  O3_CHECK(!o3ParseShard("0/5", shard) && !o3ParseShard("6/5", shard) &&
+           !o3ParseShard("1/0", shard) && !o3ParseShard("1/2x", shard));
+
+  const std::vector<O3Location> grid =
+      o3GridLocations(O3Grid(-90, 90, -180, 175, 5));
+
+  for (int count : {1, 2, 3, 7, 16}) {
+    const std::vector<int> shardOf = o3ShardAssignment(grid, count);
+    O3_CHECK(shardOf == o3ShardAssignment(grid, count));
+
+    // The shards' lists, put together, are the grid once over
+    std::multiset<std::string> seen;
+    std::vector<double> load(count + 1, 0.0);
+    for (int i = 1; i <= count; ++i) {
+      const O3Shard s{i, count};
+      const std::vector<O3Location> part = o3ShardLocations(grid, s);
+      for (const O3Location &loc : part) {
+        seen.insert(loc.name);
+        load[i] += o3LocationCost(loc.lat);
+      }
+    }
+    bool once = seen.size() == grid.size();
+    for (const O3Location &loc : grid)
+      once = once && seen.count(loc.name) == 1;
+    O3_CHECK(once);
+
+    // Greedy LPT: no shard exceeds another by more than the largest cost
+    double lo = load[1], hi = load[1];
+    for (int i = 2; i <= count; ++i) {
+      lo = std::min(lo, load[i]);
+      hi = std::max(hi, load[i]);
+    }
+    O3_CHECK(hi - lo <= o3LocationCost(90) + 1e-9);
+  }
+
+  // More shards than locations: the extra shards are empty
+  const std::vector<O3Location> few = {{"A", 0, 0}, {"B", 10, 0}};
+  const std::vector<int> shardOf = o3ShardAssignment(few, 4);
+  O3_CHECK(shardOf.size() == 2 && shardOf[0] != shardOf[1]);
+
+  // Plans round trip
+  const std::string path = o3CheckTempPath("shard.plan");
+  const O3Shard planned{3, 4};
+  const std::vector<O3Location> part = o3ShardLocations(grid, planned);
+  O3_CHECK(o3WriteShardPlan(path, planned, part));
+  O3Shard read;
+  std::vector<std::string> names;
+  O3_CHECK(o3ReadShardPlan(path, read, names));
+  O3_CHECK(read.index == 3 && read.count == 4 && names.size() == part.size());
+  bool sameNames = names.size() == part.size();
+  for (size_t i = 0; sameNames && i < names.size(); ++i)
+    sameNames = names[i] == part[i].name;
+  O3_CHECK(sameNames);
+
+  // With coordinates, for analysis_runner --shard; fractional ones too
+  const std::vector<O3Location> points = {{"BOG", 4.36, -74.04},
+                                          {"LAT2.5LON-0.5", 2.5, -0.5}};
+  O3_CHECK(o3WriteShardPlan(path, O3Shard{1, 2}, points));
+  std::vector<O3Location> back;
+  O3_CHECK(o3ReadShardPlan(path, read, back) && read.index == 1 &&
+           back.size() == 2);
+  O3_CHECK(back.size() == 2 && back[0].name == "BOG" && back[0].lat == 4.36 &&
+           back[0].lon == -74.04 && back[1].lat == 2.5 && back[1].lon == -0.5);
+  std::remove(path.c_str());
+
+  return o3CheckResult("testShard");
+}
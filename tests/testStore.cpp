@@ -0,0 +1,82 @@
+// testStore.cpp
+// O3StoreWriter / O3Store round trip: cell layout, nearest and fill-aware
+// bilinear queries, date clamping and points outside the grid.
+#include "../include/o3Store.h"
+#include "o3Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Value of cell c on day i of the test store
+static float valueOf(O3CellId c, int i) { return 200.0f + 10.0f * c + i; }
+
+int main() {
+  const std::string path = o3CheckTempPath("store.o3s");
+  const O3Grid grid(-10, 10, 0, 20, 10); // 3 x 3 cells
+  const int32_t day0 = o3DaysFromCivil(2000, 1, 1);
+  const int32_t nDays = 30;
+
+  {
+    O3StoreWriter writer(path, grid, day0, nDays);
+    std::vector<float> series(nDays);
+    for (O3CellId c = 0; c < grid.size(); ++c) {
+      if (c == 8)
+        continue; // never written: stays O3_MISSING
+      for (int i = 0; i < nDays; ++i)
+        series[i] = valueOf(c, i);
+      if (c == 1)
+        series[5] = -1; // invalid satellite value
+      writer.writeCell(c, series.data());
+    }
+  }
+
+  O3Store store(path);
+  const O3Grid g = store.grid();
+  O3_CHECK(g.nLat == 3 && g.nLon == 3 && g.step == 10);
+  O3_CHECK(store.firstDay() == day0 && store.lastDay() == day0 + nDays - 1);
+  O3_CHECK(store.filled(0) == nullptr);
+
+  // Every cell holds what was written, in cell ID order
+  bool same = true;
+  for (O3CellId c = 0; c < 8; ++c)
+    for (int i = 0; i < nDays; ++i)
+      same = same && (store.cell(c)[i] == valueOf(c, i) ||
+                      (c == 1 && i == 5 && store.cell(c)[i] == -1));
+  O3_CHECK(same);
+  O3_CHECK(store.cell(8)[0] == O3_MISSING &&
+           store.cell(8)[nDays - 1] == O3_MISSING);
+
+  // Nearest: cell (iLat 1, iLon 2) is lat 0, lon 20, ID 5
+  std::vector<float> v = store.series(1, 19, day0, day0 + 2);
+  O3_CHECK(v.size() == 3 && v[0] == valueOf(5, 0) && v[2] == valueOf(5, 2));
+
+  // Range clamped to the store
+  v = store.series(0, 0, day0 - 10, day0 + 100);
+  O3_CHECK(v.size() == static_cast<size_t>(nDays));
+  O3_CHECK(store.series(0, 0, day0 + 100, day0 + 200).empty());
+
+  // Bilinear halfway between cells 0 and 1 (lat -10, lon 0 and 10)
+  v = store.series(-10, 5, day0, day0 + 5, O3Interp::Bilinear);
+  O3_CHECK(v.size() == 6);
+  O3_CHECK(std::fabs(v[0] - (valueOf(0, 0) + valueOf(1, 0)) / 2) < 1e-3f);
+  // A marker corner drops out and the weights are renormalised
+  O3_CHECK(std::fabs(v[5] - valueOf(0, 5)) < 1e-3f);
+
+  // Bilinear at the centre of four cells
+  v = store.series(-5, 5, day0, day0, O3Interp::Bilinear);
+  const float centre =
+      (valueOf(0, 0) + valueOf(1, 0) + valueOf(3, 0) + valueOf(4, 0)) / 4;
+  O3_CHECK(v.size() == 1 && std::fabs(v[0] - centre) < 1e-3f);
+
+  // Within half a step of the edge the edge cell answers; beyond, nothing
+  O3_CHECK(store.covers(14.9, -4.9) && store.covers(-14.9, 24.9));
+  O3_CHECK(!store.covers(15.1, 0) && !store.covers(0, 25.1));
+  v = store.series(14, -4, day0, day0);
+  O3_CHECK(v.size() == 1 && v[0] == valueOf(6, 0));
+  O3_CHECK(store.series(60, 0, day0, day0 + 5).empty());
+  O3_CHECK(store.series(60, 0, day0, day0 + 5, O3Interp::Bilinear).empty());
+
+  std::remove(path.c_str());
+  return o3CheckResult("testStore");
+}
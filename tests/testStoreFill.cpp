@@ -0,0 +1,175 @@
+// testStoreFill.cpp
+// O3StoreFiller on a synthetic store with known values behind its gaps:
+// flags and observed days, maxGap, cells without data, thread count
+// independence, and the error of each anomaly estimate.
+#include "../include/o3StoreFill.h"
+#include "o3Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Root mean square error of the filled days against the truth
+static double filledError(const O3Store &filled,
+                          const std::vector<std::vector<float>> &truth) {
+  double se = 0;
+  size_t n = 0;
+  for (O3CellId c = 0; c < filled.grid().size(); ++c) {
+    const float *v = filled.cell(c);
+    const uint8_t *f = filled.filled(c);
+    for (size_t i = 0; i < truth[c].size(); ++i) {
+      if (f[i]) {
+        se += (v[i] - truth[c][i]) * (v[i] - truth[c][i]);
+        ++n;
+      }
+    }
+  }
+  return n ? std::sqrt(se / n) : 0;
+}
+
+int main() {
+  // Global 5 x 12 grid, so longitude neighbours wrap
+  const O3Grid grid(-20, 20, -180, 150, 30);
+  const int32_t day0 = o3DaysFromCivil(2000, 1, 1);
+  const int32_t nDays = o3DaysFromCivil(2003, 12, 31) - day0 + 1;
+  const O3CellId empty = 7; // no data at all
+
+  // Truth: seasonal climatology + a large-scale AR(1) anomaly shared by
+  // all cells + a local AR(1) anomaly. Gaps of 1-20 days, marked -1 or -3.
+  std::mt19937 rng(11);
+  std::normal_distribution<float> noise(0, 1);
+  std::uniform_real_distribution<float> uniform(0, 1);
+  std::vector<float> common(nDays);
+  float a = 0;
+  for (int32_t i = 0; i < nDays; ++i)
+    common[i] = a = 0.9f * a + 4 * noise(rng);
+
+  std::vector<std::vector<float>> truth(grid.size()), observed(grid.size());
+  for (O3CellId c = 0; c < grid.size(); ++c) {
+    truth[c].resize(nDays);
+    float local = 0;
+    for (int32_t i = 0; i < nDays; ++i) {
+      local = 0.8f * local + 3 * noise(rng);
+      const float season =
+          20 * std::sin(2 * 3.14159265f * o3LeapSlot(day0 + i) / 366);
+      truth[c][i] = 280 + 2 * grid.latOf(c) + season + common[i] + local;
+    }
+    observed[c] = truth[c];
+    for (int32_t i = 0; i < nDays; ++i) {
+      if (uniform(rng) < 0.03f) {
+        const int length = 1 + static_cast<int>(uniform(rng) * 20);
+        const float marker = uniform(rng) < 0.5f ? -1.0f : O3_MISSING;
+        for (int k = 0; k < length && i + k < nDays; ++k)
+          observed[c][i + k] = marker;
+      }
+    }
+    if (c == empty)
+      std::fill(observed[c].begin(), observed[c].end(), O3_MISSING);
+  }
+  // One 60 day gap, for maxGap
+  const O3CellId longGapCell = 20;
+  const int32_t longGap0 = 400;
+  for (int32_t i = longGap0; i < longGap0 + 60; ++i)
+    observed[longGapCell][i] = O3_MISSING;
+
+  const std::string input = o3CheckTempPath("fill_in.o3s");
+  {
+    O3StoreWriter writer(input, grid, day0, nDays);
+    for (O3CellId c = 0; c < grid.size(); ++c)
+      writer.writeCell(c, observed[c].data());
+  }
+  O3Store store(input);
+
+  double error[3] = {};
+  const O3Anomaly modes[3] = {O3Anomaly::None, O3Anomaly::Temporal,
+                              O3Anomaly::Spatial};
+  for (int k = 0; k < 3; ++k) {
+    O3StoreFillOptions options;
+    options.anomaly = modes[k];
+    const std::string output = o3CheckTempPath("fill_out.o3s");
+    const O3StoreFillResult r = O3StoreFiller(store, options).run(output);
+    O3Store filled(output);
+
+    O3_CHECK(r.cells == static_cast<size_t>(grid.size()) &&
+             r.cellsWithData == r.cells - 1);
+    O3_CHECK(r.meanPhi > 0.5 && r.meanPhi < 1);
+    O3_CHECK(filled.header().flagsOffset != 0 && filled.filled(0));
+
+    // Observed days are kept with flag 0; every gap day is filled and
+    // flagged with its marker; observedOnly reads the markers back
+    bool kept = true, flagged = true, positive = true;
+    uint64_t nFilled = 0;
+    for (O3CellId c = 0; c < grid.size(); ++c) {
+      if (c == empty)
+        continue;
+      const float *v = filled.cell(c);
+      const uint8_t *f = filled.filled(c);
+      for (int32_t i = 0; i < nDays; ++i) {
+        const float o = observed[c][i];
+        if (o > 0) {
+          kept = kept && v[i] == o && f[i] == 0;
+        } else {
+          flagged = flagged && f[i] == static_cast<uint8_t>(-o);
+          positive = positive && v[i] > 0;
+          ++nFilled;
+        }
+      }
+    }
+    O3_CHECK(kept && flagged && positive);
+    O3_CHECK(r.filledDays == nFilled &&
+             r.leftDays == static_cast<uint64_t>(nDays));
+    O3_CHECK(std::memcmp(filled.cell(empty), observed[empty].data(),
+                         nDays * sizeof(float)) == 0);
+
+    const double lat = grid.latOf(3), lon = grid.lonOf(3);
+    const std::vector<float> back =
+        filled.series(lat, lon, day0, day0 + nDays - 1, O3Interp::Nearest,
+                      true);
+    O3_CHECK(back == observed[3]);
+
+    error[k] = filledError(filled, truth);
+    std::remove(output.c_str());
+  }
+  // Each estimate improves on the one before: the climatology alone, the
+  // cell's own neighbouring days, the neighbouring cells that day
+  O3_CHECK(error[0] > 0 && error[1] < 0.9 * error[0]);
+  O3_CHECK(error[2] < 0.9 * error[1]);
+
+  // maxGap leaves longer gaps as they were; the thread count does not
+  // change the result
+  {
+    O3StoreFillOptions options;
+    options.maxGap = 30;
+    options.threads = 1;
+    const std::string one = o3CheckTempPath("fill_one.o3s");
+    const std::string many = o3CheckTempPath("fill_many.o3s");
+    O3StoreFiller(store, options).run(one);
+    options.threads = 4;
+    const O3StoreFillResult r = O3StoreFiller(store, options).run(many);
+    O3Store a1(one), a4(many);
+    const float *v = a1.cell(longGapCell);
+    const uint8_t *f = a1.filled(longGapCell);
+    bool left = true;
+    for (int32_t i = longGap0; i < longGap0 + 60; ++i)
+      left = left && v[i] == O3_MISSING && f[i] == 0;
+    O3_CHECK(left);
+    O3_CHECK(r.leftDays >= 60u + nDays);
+
+    const size_t bytes = static_cast<size_t>(grid.size()) * nDays;
+    O3_CHECK(std::memcmp(a1.cell(0), a4.cell(0), bytes * sizeof(float)) ==
+                 0 &&
+             std::memcmp(a1.filled(0), a4.filled(0), bytes) == 0);
+    std::remove(one.c_str());
+    std::remove(many.c_str());
+  }
+
+  O3StoreFillOptions options;
+  O3_CHECK(o3ParseAnomaly("spatial", options.anomaly) &&
+           options.anomaly == O3Anomaly::Spatial);
+  O3_CHECK(!o3ParseAnomaly("kriging", options.anomaly));
+
+  std::remove(input.c_str());
+  return o3CheckResult("testStoreFill");
+}
@@ -0,0 +1,109 @@
+// testTextIO.cpp
+// O3TextWriter writes the same text as the iostream code it replaced, and
+// O3TextReader reads back what iostream >> reads, in memory and through
+// files larger than the write block.
+#include "../include/o3TextIO.h"
+#include "o3Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+  // Values as they occur in .dat, sunspot and chi2 files, plus edge cases
+  std::vector<double> values = {0,        -1,        -2,      -3,
+                                287.5,    301.25f,   1e-7,    -4.5e-5,
+                                123456.7, 1234567.0, 1e21,    0.1,
+                                2.0 / 3,  -0.000123, 99999.95};
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> du(100, 500);
+  std::uniform_real_distribution<float> small(-1, 1);
+  for (int i = 0; i < 2000; ++i) {
+    values.push_back(du(rng));
+    values.push_back(static_cast<float>(du(rng)));
+    values.push_back(small(rng) * 1e-3);
+  }
+
+  // Writer: same text as ostream's default %g formatting
+  O3TextWriter out;
+  std::ostringstream ref;
+  for (size_t i = 0; i < values.size(); ++i) {
+    const int day = static_cast<int>(i % 31) + 1, year = 1979 + i % 46;
+    out << day << '\t' << static_cast<int>(i % 12 + 1) << '\t' << year << '\t'
+        << values[i] << '\n';
+    ref << day << '\t' << i % 12 + 1 << '\t' << year << '\t' << values[i]
+        << '\n';
+  }
+  out << static_cast<long>(-1234567890123L) << ' ' << std::string_view("end");
+  ref << -1234567890123L << ' ' << "end";
+  O3_CHECK(out.str() == ref.str());
+
+  O3TextWriter padded;
+  char expect[64];
+  std::snprintf(expect, sizeof(expect), "%02d/%02d/%04d/%02d", 7, 12, 995, -3);
+  padded.padded(7, 2) << '/';
+  padded.padded(12, 2) << '/';
+  padded.padded(995, 4) << '/';
+  padded.padded(-3, 2);
+  O3_CHECK(padded.str() == expect);
+
+  // Reader: the same numbers as istream >>
+  O3TextReader in;
+  in.assign(ref.str());
+  std::istringstream refIn(ref.str());
+  int d, m, y, rd, rm, ry;
+  double v, rv;
+  size_t rows = 0;
+  bool same = true;
+  while (in.row(d, m, y, v)) {
+    refIn >> rd >> rm >> ry >> rv;
+    same = same && d == rd && m == rm && y == ry && v == rv;
+    ++rows;
+  }
+  // The trailing "-1234567890123 end" stops the int rows
+  O3_CHECK(same && rows == values.size());
+  long big;
+  O3_CHECK(in.row(big) && big == -1234567890123L && !in.row(v) &&
+           !in.atEnd());
+
+  // CRLF lines, a leading '+', float fields and the end of the data
+  in.assign("1\t2\t+3\t-1\r\n4 5 6 2.5e2\r\n\r\n");
+  float f;
+  O3_CHECK(in.row(d, m, y, f) && d == 1 && m == 2 && y == 3 && f == -1.0f);
+  O3_CHECK(in.row(d, m, y, f) && d == 4 && y == 6 && f == 250.0f);
+  O3_CHECK(in.atEnd() && !in.row(d));
+
+  // Files: several write blocks, read back whole
+  const std::string path = o3CheckTempPath("text.dat");
+  std::string text;
+  {
+    O3TextWriter file(path);
+    O3_CHECK(file.isOpen());
+    O3TextWriter memory;
+    for (int i = 0; i < 200000; ++i) {
+      file << i << '\t' << i * 0.37 << '\n';
+      memory << i << '\t' << i * 0.37 << '\n';
+    }
+    O3_CHECK(file.close());
+    text = memory.str();
+  }
+  O3_CHECK(text.size() > 2 * (1 << 20));
+  std::ifstream raw(path, std::ios::binary);
+  const std::string onDisk((std::istreambuf_iterator<char>(raw)),
+                           std::istreambuf_iterator<char>());
+  O3_CHECK(onDisk == text);
+  O3_CHECK(in.open(path));
+  int k = 0, i;
+  bool ordered = true;
+  while (in.row(i, v))
+    ordered = ordered && i == k++;
+  O3_CHECK(ordered && k == 200000 && in.atEnd());
+  std::remove(path.c_str());
+  O3_CHECK(!in.open(path));
+
+  return o3CheckResult("testTextIO");
+}
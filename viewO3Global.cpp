@@ -15,9 +15,13 @@
 #include "TLegend.h"
 #include "TList.h"
 #include "TMath.h"
+#include "TMemFile.h"
 #include "TRootEmbeddedCanvas.h"
+#include "include/npyWriter.h"
+#include "include/o3Archive.h"
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -314,6 +318,7 @@ void O3ViewerGUI::ScanLocations() {
 
   const char *entry;
   int locCount = 0;
+  std::set<std::string> listed;
 
   while ((entry = gSystem->GetDirEntry(dirp))) {
     TString dirName = entry;
@@ -330,6 +335,7 @@ void O3ViewerGUI::ScanLocations() {
             Form("%s/%s_global.root", fullPath.Data(), locName.Data());
         if (gSystem->AccessPathName(rootFile.Data()) == 0) {
           fLocationCombo->AddEntry(locName.Data(), locCount++);
+          listed.insert(locName.Data());
         }
       }
     }
@@ -337,6 +343,16 @@ void O3ViewerGUI::ScanLocations() {
 
   gSystem->FreeDirectory(dirp);
 
+  // Locations of a packed run (run.o3a) without a folder on disk
+  if (const O3Archive *archive = o3RunArchive(fBaseDir.Data())) {
+    for (const auto &item : archive->list()) {
+      if (item.second == "skim/" + item.first + "_global.root" &&
+          listed.insert(item.first).second) {
+        fLocationCombo->AddEntry(item.first.c_str(), locCount++);
+      }
+    }
+  }
+
   if (locCount > 0) {
     fLocationCombo->Select(0);
     fStatusLabel->SetText(Form("Found %d location(s)", locCount));
@@ -386,6 +402,16 @@ void O3ViewerGUI::LoadFile() {
   }
 
   if (fileName == "") {
+    // Not on disk: open it from the run archive in memory
+    std::string blob;
+    if (o3ReadArtifact(possiblePaths[0].Data(), blob, fBaseDir.Data())) {
+      fRootFile = new TMemFile(possiblePaths[0].Data(), &blob[0],
+                               (Long64_t)blob.size(), "READ");
+      fStatusLabel->SetText(Form("Loaded: %s (archive)", locName.Data()));
+      OnCategorySelected();
+      return;
+    }
+
     fStatusLabel->SetText(
         Form("Error: Cannot find ROOT file for %s", locName.Data()));
     return;
@@ -1428,6 +1454,12 @@ void O3ViewerGUI::ExportData() {
     outFile << "# Export Date: " << TDatime().AsString() << std::endl;
     outFile << "#" << std::endl;
 
+    // Binary copy for Python: columns series (0 history, 1 teo), year,
+    // point, x, y
+    TString npyFile = outputFile;
+    npyFile.ReplaceAll(".txt", ".npy");
+    NpyWriter<Double_t> npy(npyFile.Data(), {5});
+
     int totalHistoryPoints = 0;
     int totalTeoPoints = 0;
     int yearsWithHistory = 0;
@@ -1460,6 +1492,9 @@ void O3ViewerGUI::ExportData() {
             grHistory->GetPoint(i, x, y);
             outFile << year.Data() << "\t" << i << "\t" << x << "\t" << y
                     << std::endl;
+            const Double_t row[5] = {0, (Double_t)year.Atoi(), (Double_t)i, x,
+                                     y};
+            npy.writeRow(row);
           }
           totalHistoryPoints += grHistory->GetN();
           yearsWithHistory++;
@@ -1481,6 +1516,9 @@ void O3ViewerGUI::ExportData() {
             grTeo->GetPoint(i, x, y);
             outFile << year.Data() << "\t" << i << "\t" << x << "\t" << y
                     << std::endl;
+            const Double_t row[5] = {1, (Double_t)year.Atoi(), (Double_t)i, x,
+                                     y};
+            npy.writeRow(row);
           }
           totalTeoPoints += grTeo->GetN();
           yearsWithTeo++;
@@ -1498,6 +1536,7 @@ void O3ViewerGUI::ExportData() {
             << totalTeoPoints << " total points" << std::endl;
 
     outFile.close();
+    npy.close();
 
     if (totalHistoryPoints > 0 || totalTeoPoints > 0) {
       fStatusLabel->SetText(Form("Exported %d years to: %s",
@@ -1549,6 +1588,14 @@ void O3ViewerGUI::ExportData() {
     int yearsWithData = 0;
     bool isGraph = true;
 
+    // Binary copy for Python, created with the first row. Rows are always
+    // (year, index, x, y, error): histogram bins (year, bin, center,
+    // content, error), graph points (year, point, x, y, NaN), so years of
+    // both kinds share one shape
+    TString npyFile = outputFile;
+    npyFile.ReplaceAll(".txt", ".npy");
+    std::unique_ptr<NpyWriter<Double_t>> npy;
+
     // Loop through all years
     for (size_t iYear = 0; iYear < yearsToExport.size(); iYear++) {
       TString year = yearsToExport[iYear];
@@ -1577,6 +1624,11 @@ void O3ViewerGUI::ExportData() {
             gr->GetPoint(i, x, y);
             outFile << year.Data() << "\t" << i << "\t" << x << "\t" << y
                     << std::endl;
+            if (!npy)
+              npy.reset(new NpyWriter<Double_t>(npyFile.Data(), {5}));
+            const Double_t row[5] = {(Double_t)year.Atoi(), (Double_t)i, x, y,
+                                     TMath::QuietNaN()};
+            npy->writeRow(row);
           }
           totalPoints += gr->GetN();
           yearsWithData++;
@@ -1592,6 +1644,12 @@ void O3ViewerGUI::ExportData() {
           outFile << year.Data() << "\t" << i << "\t" << h->GetBinCenter(i)
                   << "\t" << h->GetBinContent(i) << "\t" << h->GetBinError(i)
                   << std::endl;
+          if (!npy)
+            npy.reset(new NpyWriter<Double_t>(npyFile.Data(), {5}));
+          const Double_t row[5] = {(Double_t)year.Atoi(), (Double_t)i,
+                                   h->GetBinCenter(i), h->GetBinContent(i),
+                                   h->GetBinError(i)};
+          npy->writeRow(row);
         }
         totalPoints += h->GetNbinsX();
         yearsWithData++;
@@ -1607,6 +1665,8 @@ void O3ViewerGUI::ExportData() {
             << totalPoints << std::endl;
 
     outFile.close();
+    if (npy)
+      npy->close();
 
     if (totalPoints > 0) {
       fStatusLabel->SetText(Form("Exported %d years to: %s",